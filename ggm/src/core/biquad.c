@@ -0,0 +1,353 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * BiQuad Filter Design and Filter Banks
+ *
+ * Coefficients are from the RBJ Audio EQ Cookbook:
+ * https://www.w3.org/TR/audio-eq-cookbook/
+ *
+ * The filter bank runs BIQUAD_LANES transposed direct form II sections in
+ * parallel SIMD lanes (SSE2/NEON, portable C elsewhere). A cascade is
+ * pipelined through the lanes, so each lane works on a sample that's one
+ * step behind the previous lane. This gives the cascade a latency of
+ * (BIQUAD_LANES - 1) samples.
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ * filter design
+ */
+
+#define LOG2_10 (3.321928094887362f)	/* math.log2(10.0) */
+
+/* biquad_design sets the coefficients for a filter type.
+ * cutoff = cutoff/center frequency (Hz)
+ * q = filter Q (> 0)
+ * gain = peak/shelf gain (dB)
+ */
+void biquad_design(struct biquad_coeffs *c, int type, float cutoff, float q, float gain) {
+	float w0 = Tau * clampf(cutoff, 1.f, 0.49f * AudioSampleFrequency) * AudioSamplePeriod;
+	float cosw = cosf(w0);
+	float alpha = sinf(w0) / (2.f * clampf_lo(q, 0.1f));
+	/* sqrt(A) = 10^(gain/80) */
+	float sa = pow2(gain * (LOG2_10 / 80.f));
+	float A = sa * sa;
+	float a0, a1, a2, b0, b1, b2;
+
+	switch (type) {
+	case BIQUAD_TYPE_LPF:
+		a0 = (1.f - cosw) * 0.5f;
+		a1 = 1.f - cosw;
+		a2 = a0;
+		b0 = 1.f + alpha;
+		b1 = -2.f * cosw;
+		b2 = 1.f - alpha;
+		break;
+	case BIQUAD_TYPE_HPF:
+		a0 = (1.f + cosw) * 0.5f;
+		a1 = -(1.f + cosw);
+		a2 = a0;
+		b0 = 1.f + alpha;
+		b1 = -2.f * cosw;
+		b2 = 1.f - alpha;
+		break;
+	case BIQUAD_TYPE_BPF:
+		a0 = alpha;
+		a1 = 0.f;
+		a2 = -alpha;
+		b0 = 1.f + alpha;
+		b1 = -2.f * cosw;
+		b2 = 1.f - alpha;
+		break;
+	case BIQUAD_TYPE_NOTCH:
+		a0 = 1.f;
+		a1 = -2.f * cosw;
+		a2 = 1.f;
+		b0 = 1.f + alpha;
+		b1 = -2.f * cosw;
+		b2 = 1.f - alpha;
+		break;
+	case BIQUAD_TYPE_PEAK:
+		a0 = 1.f + (alpha * A);
+		a1 = -2.f * cosw;
+		a2 = 1.f - (alpha * A);
+		b0 = 1.f + (alpha / A);
+		b1 = -2.f * cosw;
+		b2 = 1.f - (alpha / A);
+		break;
+	case BIQUAD_TYPE_LOWSHELF:{
+			float k = 2.f * sa * alpha;
+			a0 = A * ((A + 1.f) - ((A - 1.f) * cosw) + k);
+			a1 = 2.f * A * ((A - 1.f) - ((A + 1.f) * cosw));
+			a2 = A * ((A + 1.f) - ((A - 1.f) * cosw) - k);
+			b0 = (A + 1.f) + ((A - 1.f) * cosw) + k;
+			b1 = -2.f * ((A - 1.f) + ((A + 1.f) * cosw));
+			b2 = (A + 1.f) + ((A - 1.f) * cosw) - k;
+			break;
+		}
+	case BIQUAD_TYPE_HIGHSHELF:{
+			float k = 2.f * sa * alpha;
+			a0 = A * ((A + 1.f) + ((A - 1.f) * cosw) + k);
+			a1 = -2.f * A * ((A - 1.f) + ((A + 1.f) * cosw));
+			a2 = A * ((A + 1.f) + ((A - 1.f) * cosw) - k);
+			b0 = (A + 1.f) - ((A - 1.f) * cosw) + k;
+			b1 = 2.f * ((A - 1.f) - ((A + 1.f) * cosw));
+			b2 = (A + 1.f) - ((A - 1.f) * cosw) - k;
+			break;
+		}
+	default:
+		LOG_ERR("bad filter type %d", type);
+		/* pass through */
+		a0 = 1.f;
+		a1 = a2 = b1 = b2 = 0.f;
+		b0 = 1.f;
+		break;
+	}
+
+	/* normalise to b0 = 1 */
+	float k = 1.f / b0;
+	c->a0 = a0 * k;
+	c->a1 = a1 * k;
+	c->a2 = a2 * k;
+	c->b1 = b1 * k;
+	c->b2 = b2 * k;
+}
+
+/******************************************************************************
+ * filter bank setup
+ */
+
+/* biquad_bank_init sets all lanes to pass through and clears the state */
+void biquad_bank_init(struct biquad_bank *bank) {
+	memset(bank, 0, sizeof(struct biquad_bank));
+	for (int i = 0; i < BIQUAD_LANES; i++) {
+		bank->a0[i] = 1.f;
+	}
+}
+
+/* biquad_bank_set sets the coefficients for a lane */
+void biquad_bank_set(struct biquad_bank *bank, int lane, const struct biquad_coeffs *c) {
+	if ((lane < 0) || (lane >= BIQUAD_LANES)) {
+		LOG_ERR("bad lane %d", lane);
+		return;
+	}
+	bank->a0[lane] = c->a0;
+	bank->a1[lane] = c->a1;
+	bank->a2[lane] = c->a2;
+	bank->b1[lane] = c->b1;
+	bank->b2[lane] = c->b2;
+}
+
+/******************************************************************************
+ * filter bank processing
+ */
+
+#if (defined(__SSE2__) || defined(__ARM_NEON)) && (BIQUAD_LANES != 4)
+#error "the SIMD filter bank needs BIQUAD_LANES == 4"
+#endif
+
+#if defined(__SSE2__)
+
+struct lanes {
+	__m128 a0, a1, a2, b1, b2;
+	__m128 s1, s2;
+};
+
+static inline void lanes_load(struct lanes *l, const struct biquad_bank *bank) {
+	l->a0 = _mm_loadu_ps(bank->a0);
+	l->a1 = _mm_loadu_ps(bank->a1);
+	l->a2 = _mm_loadu_ps(bank->a2);
+	l->b1 = _mm_loadu_ps(bank->b1);
+	l->b2 = _mm_loadu_ps(bank->b2);
+	l->s1 = _mm_loadu_ps(bank->s1);
+	l->s2 = _mm_loadu_ps(bank->s2);
+}
+
+static inline void lanes_store(const struct lanes *l, struct biquad_bank *bank) {
+	_mm_storeu_ps(bank->s1, l->s1);
+	_mm_storeu_ps(bank->s2, l->s2);
+}
+
+/* lanes_step runs one sample through each lane (transposed direct form 2) */
+static inline __m128 lanes_step(struct lanes *l, __m128 x) {
+	__m128 y = _mm_add_ps(_mm_mul_ps(l->a0, x), l->s1);
+	l->s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(l->a1, x), _mm_mul_ps(l->b1, y)), l->s2);
+	l->s2 = _mm_sub_ps(_mm_mul_ps(l->a2, x), _mm_mul_ps(l->b2, y));
+	return y;
+}
+
+/* biquad_bank_parallel filters BIQUAD_LANES buffers (in place), one per lane */
+void biquad_bank_parallel(struct biquad_bank *bank, float *buf[BIQUAD_LANES]) {
+	struct lanes l;
+
+	lanes_load(&l, bank);
+	for (size_t i = 0; i < AudioBufferSize; i += 4) {
+		/* load 4 samples per lane and transpose to 4 steps of 4 lanes */
+		__m128 x0 = _mm_loadu_ps(&buf[0][i]);
+		__m128 x1 = _mm_loadu_ps(&buf[1][i]);
+		__m128 x2 = _mm_loadu_ps(&buf[2][i]);
+		__m128 x3 = _mm_loadu_ps(&buf[3][i]);
+		_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+		x0 = lanes_step(&l, x0);
+		x1 = lanes_step(&l, x1);
+		x2 = lanes_step(&l, x2);
+		x3 = lanes_step(&l, x3);
+		_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+		_mm_storeu_ps(&buf[0][i], x0);
+		_mm_storeu_ps(&buf[1][i], x1);
+		_mm_storeu_ps(&buf[2][i], x2);
+		_mm_storeu_ps(&buf[3][i], x3);
+	}
+	lanes_store(&l, bank);
+}
+
+/* biquad_bank_cascade filters a buffer through all lanes in series */
+void biquad_bank_cascade(struct biquad_bank *bank, const float *in, float *out) {
+	struct lanes l;
+	__m128 p = _mm_loadu_ps(bank->pipe);
+
+	lanes_load(&l, bank);
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		/* shift the pipeline up a lane, lane 0 gets the new input */
+		__m128 x = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(p), 4));
+		x = _mm_move_ss(x, _mm_set_ss(in[i]));
+		p = lanes_step(&l, x);
+		out[i] = _mm_cvtss_f32(_mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+	lanes_store(&l, bank);
+	_mm_storeu_ps(bank->pipe, p);
+}
+
+#elif defined(__ARM_NEON)
+
+struct lanes {
+	float32x4_t a0, a1, a2, b1, b2;
+	float32x4_t s1, s2;
+};
+
+static inline void lanes_load(struct lanes *l, const struct biquad_bank *bank) {
+	l->a0 = vld1q_f32(bank->a0);
+	l->a1 = vld1q_f32(bank->a1);
+	l->a2 = vld1q_f32(bank->a2);
+	l->b1 = vld1q_f32(bank->b1);
+	l->b2 = vld1q_f32(bank->b2);
+	l->s1 = vld1q_f32(bank->s1);
+	l->s2 = vld1q_f32(bank->s2);
+}
+
+static inline void lanes_store(const struct lanes *l, struct biquad_bank *bank) {
+	vst1q_f32(bank->s1, l->s1);
+	vst1q_f32(bank->s2, l->s2);
+}
+
+/* lanes_step runs one sample through each lane (transposed direct form 2) */
+static inline float32x4_t lanes_step(struct lanes *l, float32x4_t x) {
+	float32x4_t y = vmlaq_f32(l->s1, l->a0, x);
+	l->s1 = vmlsq_f32(vmlaq_f32(l->s2, l->a1, x), l->b1, y);
+	l->s2 = vmlsq_f32(vmulq_f32(l->a2, x), l->b2, y);
+	return y;
+}
+
+/* transpose4 transposes a 4x4 matrix of floats */
+static inline void transpose4(float32x4_t * x) {
+	float32x4x2_t t0 = vtrnq_f32(x[0], x[1]);
+	float32x4x2_t t1 = vtrnq_f32(x[2], x[3]);
+	x[0] = vcombine_f32(vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]));
+	x[1] = vcombine_f32(vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]));
+	x[2] = vcombine_f32(vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]));
+	x[3] = vcombine_f32(vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]));
+}
+
+/* biquad_bank_parallel filters BIQUAD_LANES buffers (in place), one per lane */
+void biquad_bank_parallel(struct biquad_bank *bank, float *buf[BIQUAD_LANES]) {
+	struct lanes l;
+	float32x4_t x[4];
+
+	lanes_load(&l, bank);
+	for (size_t i = 0; i < AudioBufferSize; i += 4) {
+		/* load 4 samples per lane and transpose to 4 steps of 4 lanes */
+		for (int j = 0; j < 4; j++) {
+			x[j] = vld1q_f32(&buf[j][i]);
+		}
+		transpose4(x);
+		for (int j = 0; j < 4; j++) {
+			x[j] = lanes_step(&l, x[j]);
+		}
+		transpose4(x);
+		for (int j = 0; j < 4; j++) {
+			vst1q_f32(&buf[j][i], x[j]);
+		}
+	}
+	lanes_store(&l, bank);
+}
+
+/* biquad_bank_cascade filters a buffer through all lanes in series */
+void biquad_bank_cascade(struct biquad_bank *bank, const float *in, float *out) {
+	struct lanes l;
+	float32x4_t p = vld1q_f32(bank->pipe);
+
+	lanes_load(&l, bank);
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		/* shift the pipeline up a lane, lane 0 gets the new input */
+		float32x4_t x = vextq_f32(vdupq_n_f32(in[i]), p, 3);
+		p = lanes_step(&l, x);
+		out[i] = vgetq_lane_f32(p, 3);
+	}
+	lanes_store(&l, bank);
+	vst1q_f32(bank->pipe, p);
+}
+
+#else
+
+/* lanes_step runs one sample through each lane (transposed direct form 2) */
+static inline void lanes_step(struct biquad_bank *bank, float *x) {
+	for (int j = 0; j < BIQUAD_LANES; j++) {
+		float y = (bank->a0[j] * x[j]) + bank->s1[j];
+		bank->s1[j] = (bank->a1[j] * x[j]) - (bank->b1[j] * y) + bank->s2[j];
+		bank->s2[j] = (bank->a2[j] * x[j]) - (bank->b2[j] * y);
+		x[j] = y;
+	}
+}
+
+/* biquad_bank_parallel filters BIQUAD_LANES buffers (in place), one per lane */
+void biquad_bank_parallel(struct biquad_bank *bank, float *buf[BIQUAD_LANES]) {
+	float x[BIQUAD_LANES];
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		for (int j = 0; j < BIQUAD_LANES; j++) {
+			x[j] = buf[j][i];
+		}
+		lanes_step(bank, x);
+		for (int j = 0; j < BIQUAD_LANES; j++) {
+			buf[j][i] = x[j];
+		}
+	}
+}
+
+/* biquad_bank_cascade filters a buffer through all lanes in series */
+void biquad_bank_cascade(struct biquad_bank *bank, const float *in, float *out) {
+	float *p = bank->pipe;
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		/* shift the pipeline up a lane, lane 0 gets the new input */
+		for (int j = BIQUAD_LANES - 1; j > 0; j--) {
+			p[j] = p[j - 1];
+		}
+		p[0] = in[i];
+		lanes_step(bank, p);
+		out[i] = p[BIQUAD_LANES - 1];
+	}
+}
+
+#endif
+
+/*****************************************************************************/
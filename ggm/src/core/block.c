@@ -11,35 +11,65 @@
  *
  * The block_mul/add() function seem immune to improvements. They use vldmia/vstmia
  * and it maybe that other functions could benefit from multiple load/store also. *
+ *
+ * When GGM_CMSIS_DSP is defined (ARM builds with the CMSIS-DSP library) the
+ * block operations map onto the equivalent arm_*_f32() functions.
  */
 
 #include "ggm.h"
 
+#if defined(GGM_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /*****************************************************************************/
 
 /* block_zero sets a buffer to zero */
 void block_zero(float *out) {
+#if defined(GGM_CMSIS_DSP)
+	arm_fill_f32(0.f, out, AudioBufferSize);
+#else
 	for (size_t i = 0; i < AudioBufferSize; i++) {
 		out[i] = 0.f;
 	}
+#endif
 }
 
 /* block_mul multiplies two buffers */
 void block_mul(float *out, float *buf) {
+#if defined(GGM_CMSIS_DSP)
+	arm_mult_f32(out, buf, out, AudioBufferSize);
+#else
 	for (size_t i = 0; i < AudioBufferSize; i++) {
 		out[i] *= buf[i];
 	}
+#endif
 }
 
 /* block_add adds two buffers */
 void block_add(float *out, float *buf) {
+#if defined(GGM_CMSIS_DSP)
+	arm_add_f32(out, buf, out, AudioBufferSize);
+#else
 	for (size_t i = 0; i < AudioBufferSize; i++) {
 		out[i] += buf[i];
 	}
+#endif
 }
 
 /* block_mul_k multiplies a block by a scalar */
 void block_mul_k(float *out, float k) {
+#if defined(GGM_CMSIS_DSP)
+	arm_scale_f32(out, k, out, AudioBufferSize);
+#else
 	size_t n = AudioBufferSize;
 
 	/* unroll x4 */
@@ -51,10 +81,14 @@ void block_mul_k(float *out, float k) {
 		out += 4;
 		n -= 4;
 	}
+#endif
 }
 
 /* block_add_k adds a scalar to a buffer */
 void block_add_k(float *out, float k) {
+#if defined(GGM_CMSIS_DSP)
+	arm_offset_f32(out, k, out, AudioBufferSize);
+#else
 	size_t n = AudioBufferSize;
 
 	/* unroll x4 */
@@ -66,10 +100,14 @@ void block_add_k(float *out, float k) {
 		out += 4;
 		n -= 4;
 	}
+#endif
 }
 
 /* block_copy copies a block */
 void block_copy(float *dst, const float *src) {
+#if defined(GGM_CMSIS_DSP)
+	arm_copy_f32((float *)src, dst, AudioBufferSize);
+#else
 	size_t n = AudioBufferSize;
 
 	/* unroll x4 */
@@ -82,10 +120,14 @@ void block_copy(float *dst, const float *src) {
 		dst += 4;
 		n -= 4;
 	}
+#endif
 }
 
 /* block_copy_mul_k copies a block and multiplies by k */
 void block_copy_mul_k(float *dst, const float *src, float k) {
+#if defined(GGM_CMSIS_DSP)
+	arm_scale_f32((float *)src, k, dst, AudioBufferSize);
+#else
 	size_t n = AudioBufferSize;
 
 	/* unroll x4 */
@@ -98,6 +140,231 @@ void block_copy_mul_k(float *dst, const float *src, float k) {
 		dst += 4;
 		n -= 4;
 	}
+#endif
+}
+
+/******************************************************************************
+ * Fused operations
+ * These combine common sequences of the operations above into a single
+ * pass, so each sample is loaded and stored once. For longer chains see
+ * BLOCK_EXPR() in ggm.h.
+ */
+
+/* block_mul_add does out = (out * a) + b */
+void block_mul_add(float *out, const float *a, const float *b) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = (out[i] * a[i]) + b[i];
+	}
+}
+
+/* block_mul_add_k does out = (out * k) + c */
+void block_mul_add_k(float *out, float k, float c) {
+	size_t n = AudioBufferSize;
+
+	/* unroll x4 */
+	while (n > 0) {
+		out[0] = (out[0] * k) + c;
+		out[1] = (out[1] * k) + c;
+		out[2] = (out[2] * k) + c;
+		out[3] = (out[3] * k) + c;
+		out += 4;
+		n -= 4;
+	}
+}
+
+/* block_mac accumulates the product of two buffers, out += a * b */
+void block_mac(float *out, const float *a, const float *b) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] += a[i] * b[i];
+	}
+}
+
+/* block_mac_k accumulates a scaled buffer, out += a * k */
+void block_mac_k(float *out, const float *a, float k) {
+	size_t n = AudioBufferSize;
+
+	/* unroll x4 */
+	while (n > 0) {
+		out[0] += a[0] * k;
+		out[1] += a[1] * k;
+		out[2] += a[2] * k;
+		out[3] += a[3] * k;
+		a += 4;
+		out += 4;
+		n -= 4;
+	}
+}
+
+/* block_mix mixes two scaled buffers, out = (a * ka) + (b * kb) */
+void block_mix(float *out, const float *a, float ka, const float *b, float kb) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = (a[i] * ka) + (b[i] * kb);
+	}
 }
 
+/******************************************************************************
+ * Gain ramps
+ * The gain changes linearly from k0 by dk per sample, so a gain change is
+ * spread across the block rather than stepping at the block boundary.
+ */
+
+/* block_copy_mul_ramp copies a block and multiplies by a linear gain ramp */
+void block_copy_mul_ramp(float *dst, const float *src, float k0, float dk) {
+	float k1 = k0 + dk;
+	float k2 = k0 + (2.f * dk);
+	float k3 = k0 + (3.f * dk);
+	float dk4 = 4.f * dk;
+	size_t n = AudioBufferSize;
+
+	/* unroll x4 */
+	while (n > 0) {
+		dst[0] = src[0] * k0;
+		dst[1] = src[1] * k1;
+		dst[2] = src[2] * k2;
+		dst[3] = src[3] * k3;
+		k0 += dk4;
+		k1 += dk4;
+		k2 += dk4;
+		k3 += dk4;
+		src += 4;
+		dst += 4;
+		n -= 4;
+	}
+}
+
+/******************************************************************************
+ * PCM conversion
+ * The audio drivers want interleaved 16-bit stereo, so we convert and
+ * interleave the left/right float buffers in a single pass. Optional TPDF
+ * dither (+/- 1 LSB peak) is added before quantisation.
+ */
+
+/* PCM16_SCALE maps -1..1 floats onto the int16_t range */
+#define PCM16_SCALE (32767.f)
+
+/* PCM16_BIAS makes the scaled sample positive so truncation is a floor */
+#define PCM16_BIAS (32768)
+
+/* pcm16_tpdf returns a triangular pdf dither value of +/- 1 LSB */
+static inline float pcm16_tpdf(uint32_t * state) {
+	return 0.5f * (randf(state) + randf(state));
+}
+
+#if defined(__ARM_FEATURE_DSP)
+
+/* pcm16_sample rounds and converts a scaled sample to a (saturated) int */
+static inline int32_t pcm16_sample(float x) {
+	return __ssat((int32_t) (x + ((float)PCM16_BIAS + 0.5f)) - PCM16_BIAS, 16);
+}
+
+/* block_to_pcm16 converts and interleaves left/right buffers as int16_t.
+ * dst must be 32-bit aligned, each left/right pair is written as a
+ * packed halfword.
+ */
+void block_to_pcm16(int16_t * dst, const float *l, const float *r, uint32_t * dither) {
+	uint32_t *out = (uint32_t *) dst;
+
+	if (dither == NULL) {
+		for (size_t i = 0; i < AudioBufferSize; i += 2) {
+			int32_t l0 = pcm16_sample(l[i] * PCM16_SCALE);
+			int32_t r0 = pcm16_sample(r[i] * PCM16_SCALE);
+			int32_t l1 = pcm16_sample(l[i + 1] * PCM16_SCALE);
+			int32_t r1 = pcm16_sample(r[i + 1] * PCM16_SCALE);
+			out[i] = (uint32_t) (l0 & 0xffff) | ((uint32_t) r0 << 16);
+			out[i + 1] = (uint32_t) (l1 & 0xffff) | ((uint32_t) r1 << 16);
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		int32_t l0 = pcm16_sample((l[i] * PCM16_SCALE) + pcm16_tpdf(dither));
+		int32_t r0 = pcm16_sample((r[i] * PCM16_SCALE) + pcm16_tpdf(dither));
+		out[i] = (uint32_t) (l0 & 0xffff) | ((uint32_t) r0 << 16);
+	}
+}
+
+#elif defined(__SSE2__)
+
+/* block_to_pcm16 converts and interleaves left/right buffers as int16_t */
+void block_to_pcm16(int16_t * dst, const float *l, const float *r, uint32_t * dither) {
+	const __m128 k = _mm_set1_ps(PCM16_SCALE);
+	__m128 dl0 = _mm_setzero_ps();
+	__m128 dl1 = _mm_setzero_ps();
+	__m128 dr0 = _mm_setzero_ps();
+	__m128 dr1 = _mm_setzero_ps();
+
+	for (size_t i = 0; i < AudioBufferSize; i += 8) {
+		if (dither != NULL) {
+			dl0 = _mm_set_ps(pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither));
+			dl1 = _mm_set_ps(pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither));
+			dr0 = _mm_set_ps(pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither));
+			dr1 = _mm_set_ps(pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither));
+		}
+		/* scale, dither and round to nearest */
+		__m128i l0 = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&l[i]), k), dl0));
+		__m128i l1 = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&l[i + 4]), k), dl1));
+		__m128i r0 = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&r[i]), k), dr0));
+		__m128i r1 = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&r[i + 4]), k), dr1));
+		/* saturate to 16 bits */
+		__m128i lx = _mm_packs_epi32(l0, l1);
+		__m128i rx = _mm_packs_epi32(r0, r1);
+		/* interleave */
+		_mm_storeu_si128((__m128i *) & dst[2 * i], _mm_unpacklo_epi16(lx, rx));
+		_mm_storeu_si128((__m128i *) & dst[2 * i + 8], _mm_unpackhi_epi16(lx, rx));
+	}
+}
+
+#elif defined(__ARM_NEON)
+
+/* block_to_pcm16 converts and interleaves left/right buffers as int16_t */
+void block_to_pcm16(int16_t * dst, const float *l, const float *r, uint32_t * dither) {
+	const float32x4_t bias = vdupq_n_f32((float)PCM16_BIAS + 0.5f);
+	const int32x4_t ofs = vdupq_n_s32(PCM16_BIAS);
+	float32x4_t dl = vdupq_n_f32(0.f);
+	float32x4_t dr = vdupq_n_f32(0.f);
+
+	for (size_t i = 0; i < AudioBufferSize; i += 4) {
+		if (dither != NULL) {
+			float tl[4] = { pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), };
+			float tr[4] = { pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), pcm16_tpdf(dither), };
+			dl = vld1q_f32(tl);
+			dr = vld1q_f32(tr);
+		}
+		/* scale, dither and round (biased truncation) */
+		float32x4_t xl = vaddq_f32(vmlaq_n_f32(dl, vld1q_f32(&l[i]), PCM16_SCALE), bias);
+		float32x4_t xr = vaddq_f32(vmlaq_n_f32(dr, vld1q_f32(&r[i]), PCM16_SCALE), bias);
+		int32x4_t il = vsubq_s32(vcvtq_s32_f32(xl), ofs);
+		int32x4_t ir = vsubq_s32(vcvtq_s32_f32(xr), ofs);
+		/* saturate to 16 bits and interleave */
+		int16x4x2_t x = { {vqmovn_s32(il), vqmovn_s32(ir)} };
+		vst2_s16(&dst[2 * i], x);
+	}
+}
+
+#else
+
+/* pcm16_sample rounds and converts a scaled sample to a (saturated) int */
+static inline int32_t pcm16_sample(float x) {
+	x = clampf(x, -PCM16_SCALE - 1.f, PCM16_SCALE);
+	return (int32_t) (x + ((float)PCM16_BIAS + 0.5f)) - PCM16_BIAS;
+}
+
+/* block_to_pcm16 converts and interleaves left/right buffers as int16_t */
+void block_to_pcm16(int16_t * dst, const float *l, const float *r, uint32_t * dither) {
+	if (dither == NULL) {
+		for (size_t i = 0; i < AudioBufferSize; i++) {
+			dst[2 * i] = (int16_t) pcm16_sample(l[i] * PCM16_SCALE);
+			dst[2 * i + 1] = (int16_t) pcm16_sample(r[i] * PCM16_SCALE);
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		dst[2 * i] = (int16_t) pcm16_sample((l[i] * PCM16_SCALE) + pcm16_tpdf(dither));
+		dst[2 * i + 1] = (int16_t) pcm16_sample((r[i] * PCM16_SCALE) + pcm16_tpdf(dither));
+	}
+}
+
+#endif
+
 /*****************************************************************************/
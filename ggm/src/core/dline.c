@@ -0,0 +1,171 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Delay Lines
+ *
+ * The ring buffer size is a power of 2 so indices wrap with a mask. Block
+ * writes and integer delay reads are split into (at most) two contiguous
+ * spans and copied with memcpy. Fractional delay reads are per sample and
+ * take an audio rate delay time (samples).
+ *
+ * The ring buffer holds the maximum delay plus a block of samples, so any
+ * tap of the block that was just written can be read.
+ */
+
+#include "ggm.h"
+
+/******************************************************************************
+ * ring buffer spans
+ */
+
+/* dline_copy_in copies n samples into the ring buffer at index i */
+static void dline_copy_in(const struct dline *d, uint32_t i, const float *src, size_t n) {
+	size_t n0 = d->mask + 1 - i;
+
+	if (n <= n0) {
+		memcpy(&d->buf[i], src, n * sizeof(float));
+	} else {
+		memcpy(&d->buf[i], src, n0 * sizeof(float));
+		memcpy(d->buf, &src[n0], (n - n0) * sizeof(float));
+	}
+}
+
+/* dline_copy_out copies n samples from the ring buffer at index i */
+static void dline_copy_out(const struct dline *d, uint32_t i, float *dst, size_t n) {
+	size_t n0 = d->mask + 1 - i;
+
+	if (n <= n0) {
+		memcpy(dst, &d->buf[i], n * sizeof(float));
+	} else {
+		memcpy(dst, &d->buf[i], n0 * sizeof(float));
+		memcpy(&dst[n0], d->buf, (n - n0) * sizeof(float));
+	}
+}
+
+/******************************************************************************
+ * delay line functions
+ */
+
+/* dline_init allocates a delay line for delays up to max samples */
+int dline_init(struct dline *d, size_t max) {
+	size_t size = 1;
+
+	while (size < (max + AudioBufferSize + 4)) {
+		size <<= 1;
+	}
+
+	d->buf = ggm_calloc(size, sizeof(float));
+	if (d->buf == NULL) {
+		LOG_ERR("unable to allocate delay line of %u samples", (unsigned int)size);
+		return -1;
+	}
+	d->mask = (uint32_t) (size - 1);
+	d->wr = 0;
+	d->max = (float)max;
+	return 0;
+}
+
+/* dline_free deallocates the delay line buffer */
+void dline_free(struct dline *d) {
+	ggm_free(d->buf);
+	d->buf = NULL;
+}
+
+/* dline_clear zeroes the delay line */
+void dline_clear(struct dline *d) {
+	memset(d->buf, 0, (d->mask + 1) * sizeof(float));
+}
+
+/* dline_write writes n (<= AudioBufferSize) samples to the delay line */
+void dline_write(struct dline *d, const float *in, size_t n) {
+	dline_copy_in(d, d->wr, in, n);
+	d->wr = (d->wr + n) & d->mask;
+}
+
+/* dline_read reads the last n samples written with an integer delay (samples) */
+void dline_read(const struct dline *d, float *out, size_t n, size_t delay) {
+	delay = (delay > (size_t)d->max) ? (size_t)d->max : delay;
+	dline_copy_out(d, (d->wr - n - delay) & d->mask, out, n);
+}
+
+/* dline_read_linear reads the last n samples written with a per sample
+ * fractional delay (samples) using linear interpolation.
+ */
+void dline_read_linear(const struct dline *d, float *out, size_t n, const float *delay) {
+	const float *buf = d->buf;
+	uint32_t mask = d->mask;
+	uint32_t base = d->wr - n;
+	float max = d->max;
+
+	for (size_t i = 0; i < n; i++) {
+		float dt = clampf(delay[i], 0.f, max);
+		uint32_t di = (uint32_t) dt;
+		float df = dt - (float)di;
+		uint32_t p = base + i - di;
+		float x0 = buf[p & mask];
+		float x1 = buf[(p - 1) & mask];
+		out[i] = x0 + (df * (x1 - x0));
+	}
+}
+
+/* dline_read_cubic reads the last n samples written with a per sample
+ * fractional delay (samples) using 4-point hermite interpolation.
+ * The minimum delay is 1 sample.
+ */
+void dline_read_cubic(const struct dline *d, float *out, size_t n, const float *delay) {
+	const float *buf = d->buf;
+	uint32_t mask = d->mask;
+	uint32_t base = d->wr - n;
+	float max = d->max;
+
+	for (size_t i = 0; i < n; i++) {
+		float dt = clampf(delay[i], 1.f, max);
+		uint32_t di = (uint32_t) dt;
+		float t = dt - (float)di;
+		uint32_t p = base + i - di;
+		float xm1 = buf[(p + 1) & mask];
+		float x0 = buf[p & mask];
+		float x1 = buf[(p - 1) & mask];
+		float x2 = buf[(p - 2) & mask];
+		float c1 = 0.5f * (x1 - xm1);
+		float c2 = xm1 - (2.5f * x0) + (2.f * x1) - (0.5f * x2);
+		float c3 = (0.5f * (x2 - xm1)) + (1.5f * (x0 - x1));
+		out[i] = (((((c3 * t) + c2) * t) + c1) * t) + x0;
+	}
+}
+
+/* dline_read_allpass reads the last n samples written with a fixed
+ * fractional delay (samples) using 1st order allpass interpolation.
+ * The allpass has a flat magnitude response, so it's a good choice for
+ * delays in feedback loops (e.g. tuned strings and combs). It isn't suited
+ * to modulated delays.
+ */
+void dline_read_allpass(const struct dline *d, struct dline_allpass *ap, float *out, size_t n, float delay) {
+	const float *buf = d->buf;
+	uint32_t mask = d->mask;
+	float dt = clampf(delay, 1.f, d->max);
+	uint32_t di = (uint32_t) dt;
+	float df = dt - (float)di;
+	uint32_t p = d->wr - n - di;
+	float y1 = ap->y1;
+
+	/* keep the fractional delay in the 0.5..1.5 range (stable group delay) */
+	if ((df < 0.5f) && (di > 1)) {
+		df += 1.f;
+		p += 1;
+	}
+	float c = (1.f - df) / (1.f + df);
+
+	for (size_t i = 0; i < n; i++) {
+		/* y[n] = c * x[n] + x[n-1] - c * y[n-1] */
+		float x0 = buf[(p + i) & mask];
+		float x1 = buf[(p + i - 1) & mask];
+		y1 = (c * (x0 - y1)) + x1;
+		out[i] = y1;
+	}
+	ap->y1 = y1;
+}
+
+/*****************************************************************************/
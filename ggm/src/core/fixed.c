@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Fixed Point (Q15/Q31) Block Operations
+ *
+ * On Cortex-M4 the float unit has no SIMD, but the DSP extension has dual
+ * 16-bit operations (QADD16, SMLALD, SMULBB/TT). The q15 functions use these
+ * to process two samples per instruction. Buffers must be 32-bit aligned.
+ * Other targets use the portable C versions.
+ */
+
+#include "ggm.h"
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+/******************************************************************************
+ * q15 block operations
+ */
+
+/* block_zero_q15 sets a buffer to zero */
+void block_zero_q15(q15_t * out) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = 0;
+	}
+}
+
+#if defined(__ARM_FEATURE_SIMD32)
+
+/* q15x2_pack packs two 16-bit values into a 32-bit word */
+static inline int16x2_t q15x2_pack(int32_t lo, int32_t hi) {
+	return (int16x2_t) ((lo & 0xffff) | ((uint32_t) hi << 16));
+}
+
+/* block_mul_q15 multiplies two buffers */
+void block_mul_q15(q15_t * out, const q15_t * buf) {
+	int16x2_t *x = (int16x2_t *) out;
+	const int16x2_t *y = (const int16x2_t *)buf;
+
+	for (size_t i = 0; i < AudioBufferSize / 2; i++) {
+		int32_t lo = __ssat(__smulbb(x[i], y[i]) >> 15, 16);
+		int32_t hi = __ssat(__smultt(x[i], y[i]) >> 15, 16);
+		x[i] = q15x2_pack(lo, hi);
+	}
+}
+
+/* block_mul_k_q15 multiplies a block by a scalar */
+void block_mul_k_q15(q15_t * out, q15_t k) {
+	int16x2_t *x = (int16x2_t *) out;
+	int16x2_t kx = q15x2_pack(k, k);
+
+	for (size_t i = 0; i < AudioBufferSize / 2; i++) {
+		int32_t lo = __ssat(__smulbb(x[i], kx) >> 15, 16);
+		int32_t hi = __ssat(__smultt(x[i], kx) >> 15, 16);
+		x[i] = q15x2_pack(lo, hi);
+	}
+}
+
+/* block_add_q15 adds two buffers (with saturation) */
+void block_add_q15(q15_t * out, const q15_t * buf) {
+	int16x2_t *x = (int16x2_t *) out;
+	const int16x2_t *y = (const int16x2_t *)buf;
+
+	for (size_t i = 0; i < AudioBufferSize / 2; i++) {
+		x[i] = __qadd16(x[i], y[i]);
+	}
+}
+
+/* block_mix_q15 mixes two scaled buffers, out = (a * ka) + (b * kb)
+ * The sum of products can be 2^31 (all values -1), so it's accumulated in
+ * 64 bits (SMLALD) rather than 32 bits (SMUAD).
+ */
+void block_mix_q15(q15_t * out, const q15_t * a, q15_t ka, const q15_t * b, q15_t kb) {
+	int16x2_t k = q15x2_pack(ka, kb);
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		/* dual multiply-accumulate */
+		int64_t acc = __smlald(q15x2_pack(a[i], b[i]), k, 0);
+		out[i] = q15_sat((int32_t) (acc >> 15));
+	}
+}
+
+#else
+
+/* block_mul_q15 multiplies two buffers */
+void block_mul_q15(q15_t * out, const q15_t * buf) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q15_mul(out[i], buf[i]);
+	}
+}
+
+/* block_mul_k_q15 multiplies a block by a scalar */
+void block_mul_k_q15(q15_t * out, q15_t k) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q15_mul(out[i], k);
+	}
+}
+
+/* block_add_q15 adds two buffers (with saturation) */
+void block_add_q15(q15_t * out, const q15_t * buf) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q15_sat((int32_t) out[i] + (int32_t) buf[i]);
+	}
+}
+
+/* block_mix_q15 mixes two scaled buffers, out = (a * ka) + (b * kb)
+ * The sum of products can be 2^31 (all values -1), so it's accumulated in
+ * 64 bits.
+ */
+void block_mix_q15(q15_t * out, const q15_t * a, q15_t ka, const q15_t * b, q15_t kb) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		int64_t acc = ((int64_t) a[i] * (int64_t) ka) + ((int64_t) b[i] * (int64_t) kb);
+		out[i] = q15_sat((int32_t) (acc >> 15));
+	}
+}
+
+#endif
+
+/* block_q15_to_float converts a q15 buffer to a float buffer */
+void block_q15_to_float(float *dst, const q15_t * src) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		dst[i] = q15_to_float(src[i]);
+	}
+}
+
+/* block_float_to_q15 converts a float buffer to a q15 buffer */
+void block_float_to_q15(q15_t * dst, const float *src) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		dst[i] = float_to_q15(src[i]);
+	}
+}
+
+/******************************************************************************
+ * q31 block operations
+ * The 32x32->64 multiplies map onto SMULL, so these are the same for all targets.
+ */
+
+/* block_mul_q31 multiplies two buffers */
+void block_mul_q31(q31_t * out, const q31_t * buf) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q31_mul(out[i], buf[i]);
+	}
+}
+
+/* block_mul_k_q31 multiplies a block by a scalar */
+void block_mul_k_q31(q31_t * out, q31_t k) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q31_mul(out[i], k);
+	}
+}
+
+/* block_add_q31 adds two buffers (with saturation) */
+void block_add_q31(q31_t * out, const q31_t * buf) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		out[i] = q31_add(out[i], buf[i]);
+	}
+}
+
+/* block_q31_to_float converts a q31 buffer to a float buffer */
+void block_q31_to_float(float *dst, const q31_t * src) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		dst[i] = q31_to_float(src[i]);
+	}
+}
+
+/* block_float_to_q31 converts a float buffer to a q31 buffer */
+void block_float_to_q31(q31_t * dst, const float *src) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		dst[i] = float_to_q31(src[i]);
+	}
+}
+
+/*****************************************************************************/
@@ -0,0 +1,200 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Goom Wave Generation
+ *
+ * A Goom Wave is a wave shape with the following segments:
+ *
+ * 1) s0: A falling (1 to -1) sine curve
+ * 2) f0: A flat piece at the bottom
+ * 3) s1: A rising (-1 to 1) sine curve
+ * 4) f1: A flat piece at the top
+ *
+ * Shape is controlled by two parameters:
+ * duty = split the total period between s0,f0 and s1,f1
+ * slope = split s0f0 and s1f1 between slope and flat.
+ *
+ * The idea for goom waves comes from: https://www.quinapalus.com/goom.html
+ *
+ * The sloped segments are C1-continuous with the flat segments so the wave
+ * is mostly well behaved. When a sloped segment becomes shorter than
+ * two samples it is effectively a step, so it's generated as one and
+ * band-limited with polyblep.
+ *
+ * A block is generated in passes. The mapping of phase to a cosine LUT
+ * phase runs 4 samples at a time (SSE2/NEON) with the segment selected by
+ * masks rather than branches. A step segment uses the same mapping with a
+ * steep slope centered on the step, so it needs no special case. The LUT
+ * lookup is done with cos_lookup_block() and the polyblep corrections (only
+ * needed for step segments) are a separate pass.
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* GOOM_STEP_BASE moves a step base at least 1 float ulp below the step center */
+#define GOOM_STEP_BASE (1.f - (2.f / 16777216.f))
+
+/* GOOM_STEP_SCALE maps a phase difference of >= 1 onto a full step */
+#define GOOM_STEP_SCALE ((float)FullCycle)
+
+/******************************************************************************
+ * wave shape
+ */
+
+/* goom_wave_step sets the phase step and works out which segments are
+ * generated as steps and the phase mapping for each portion of the wave.
+ * LUT phase = clamp((x - base) * scale, 0, HalfCycle) (+ HalfCycle for s1f1)
+ * A step segment has a base just below the step center and a very
+ * steep slope, so it switches when x reaches the center.
+ */
+void goom_wave_step(struct goom_wave *w, uint32_t xstep) {
+	/* how much of a slope segment do we cover per sample? */
+	float dx = (float)xstep;
+	bool ok = (xstep != 0) && (xstep <= HalfCycle);
+
+	w->xstep = xstep;
+	w->step0 = ok && (dx * w->k0 > 0.5f);
+	w->step1 = ok && (dx * w->k1 > 0.5f);
+
+	/* s0: cosine from 0 to HalfCycle, or a 1 to -1 step at c0 */
+	if (w->step0) {
+		w->base0 = (float)w->c0 * GOOM_STEP_BASE;
+		w->scale0 = GOOM_STEP_SCALE;
+	} else {
+		w->base0 = 0.f;
+		w->scale0 = w->k0 * (float)HalfCycle;
+	}
+	/* s1: cosine from HalfCycle to FullCycle, or a -1 to 1 step at c1 */
+	if (w->step1) {
+		w->base1 = (float)w->c1 * GOOM_STEP_BASE;
+		w->scale1 = GOOM_STEP_SCALE;
+	} else {
+		w->base1 = w->tp;
+		w->scale1 = w->k1 * (float)HalfCycle;
+	}
+}
+
+/* goom_wave_shape sets the wave shape (duty and slope are 0..1) */
+void goom_wave_shape(struct goom_wave *w, float duty, float slope) {
+	/* update duty cycle */
+	w->tp = (uint32_t) ((float)FullCycle * map_lin(duty, 0.05f, 0.5f));
+	/* Work out the portion of s0f0/s1f1 that is sloped. */
+	slope = map_lin(slope, 0.1f, 1.f);
+	/* scaling constant for s0, map the slope to the LUT. */
+	w->k0 = 1.f / ((float)(w->tp) * slope);
+	/* scaling constant for s1, map the slope to the LUT. */
+	w->k1 = 1.f / ((float)(FullCycle - 1 - w->tp) * slope);
+	/* this phase reset value gives zero output */
+	w->xreset = (uint32_t) ((float)(w->tp) * slope * 0.5f);
+	/* segment centers */
+	w->c0 = w->xreset;
+	w->c1 = w->tp + (uint32_t) ((float)(FullCycle - 1 - w->tp) * slope * 0.5f);
+	goom_wave_step(w, w->xstep);
+}
+
+/******************************************************************************
+ * block generation
+ */
+
+/* goom_map maps the phases of a block onto cosine LUT phases */
+static void goom_map(const struct goom_wave *w, const uint32_t *x, uint32_t *ph) {
+#if defined(__SSE2__)
+	/* uint32_t <-> float conversions are done with a 2^31 offset */
+	const __m128i sign = _mm_set1_epi32((int)HalfCycle);
+	const __m128 half = _mm_set1_ps((float)HalfCycle);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 tp = _mm_set1_ps(w->tp);
+	const __m128 base0 = _mm_set1_ps(w->base0);
+	const __m128 base1 = _mm_set1_ps(w->base1);
+	const __m128 scale0 = _mm_set1_ps(w->scale0);
+	const __m128 scale1 = _mm_set1_ps(w->scale1);
+
+	for (size_t i = 0; i < AudioBufferSize; i += 4) {
+		__m128i xi = _mm_loadu_si128((const __m128i *)&x[i]);
+		__m128 xf = _mm_add_ps(_mm_cvtepi32_ps(_mm_xor_si128(xi, sign)), half);
+		/* select the s0f0 or s1f1 mapping */
+		__m128 s1 = _mm_cmpge_ps(xf, tp);
+		__m128 base = _mm_or_ps(_mm_and_ps(s1, base1), _mm_andnot_ps(s1, base0));
+		__m128 scale = _mm_or_ps(_mm_and_ps(s1, scale1), _mm_andnot_ps(s1, scale0));
+		__m128i lut = _mm_and_si128(_mm_castps_si128(s1), sign);
+		/* map and clamp to 0..HalfCycle */
+		__m128 y = _mm_mul_ps(_mm_sub_ps(xf, base), scale);
+		y = _mm_min_ps(_mm_max_ps(y, zero), half);
+		__m128i yi = _mm_add_epi32(_mm_cvttps_epi32(_mm_sub_ps(y, half)), sign);
+		_mm_storeu_si128((__m128i *) & ph[i], _mm_add_epi32(yi, lut));
+	}
+#elif defined(__ARM_NEON)
+	const uint32x4_t half = vdupq_n_u32(HalfCycle);
+	const float32x4_t halff = vdupq_n_f32((float)HalfCycle);
+	const float32x4_t zero = vdupq_n_f32(0.f);
+	const float32x4_t tp = vdupq_n_f32(w->tp);
+	const float32x4_t base0 = vdupq_n_f32(w->base0);
+	const float32x4_t base1 = vdupq_n_f32(w->base1);
+	const float32x4_t scale0 = vdupq_n_f32(w->scale0);
+	const float32x4_t scale1 = vdupq_n_f32(w->scale1);
+
+	for (size_t i = 0; i < AudioBufferSize; i += 4) {
+		float32x4_t xf = vcvtq_f32_u32(vld1q_u32(&x[i]));
+		/* select the s0f0 or s1f1 mapping */
+		uint32x4_t s1 = vcgeq_f32(xf, tp);
+		float32x4_t base = vbslq_f32(s1, base1, base0);
+		float32x4_t scale = vbslq_f32(s1, scale1, scale0);
+		uint32x4_t lut = vandq_u32(s1, half);
+		/* map and clamp to 0..HalfCycle */
+		float32x4_t y = vmulq_f32(vsubq_f32(xf, base), scale);
+		y = vminq_f32(vmaxq_f32(y, zero), halff);
+		vst1q_u32(&ph[i], vaddq_u32(vcvtq_u32_f32(y), lut));
+	}
+#else
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		float xf = (float)x[i];
+		/* select the s0f0 or s1f1 mapping */
+		bool s1 = (xf >= w->tp);
+		float base = s1 ? w->base1 : w->base0;
+		float scale = s1 ? w->scale1 : w->scale0;
+		uint32_t lut = s1 ? HalfCycle : 0;
+		/* map and clamp to 0..HalfCycle */
+		float y = clampf((xf - base) * scale, 0.f, (float)HalfCycle);
+		ph[i] = (uint32_t) y + lut;
+	}
+#endif
+}
+
+/* goom_blep adds the polyblep corrections for short s0/s1 segments */
+static void goom_blep(const struct goom_wave *w, const uint32_t *x, float *out) {
+	float dt = blep_phase(w->xstep);
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		float y = 0.f;
+		if (w->step0) {
+			/* step of -2 at the center of s0 */
+			y -= polyblep(blep_phase(x[i] - w->c0), dt);
+		}
+		if (w->step1) {
+			/* step of +2 at the center of s1 */
+			y += polyblep(blep_phase(x[i] - w->c1), dt);
+		}
+		out[i] += y;
+	}
+}
+
+/* goom_wave_gen generates AudioBufferSize samples for a block of phases */
+void goom_wave_gen(const struct goom_wave *w, const uint32_t *x, float *out) {
+	uint32_t ph[AudioBufferSize];
+
+	goom_map(w, x, ph);
+	cos_lookup_block(ph, out);
+	if (w->step0 || w->step1) {
+		goom_blep(w, x, out);
+	}
+}
+
+/*****************************************************************************/
@@ -6,13 +6,37 @@
 
 #include "ggm.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 /******************************************************************************
- * LUT based cosine function - generated by ./tools/lut.py
+ * LUT based cosine function
+ *
+ * The table has (1 << COS_LUT_BITS) entries of (y, dy) pairs for linear
+ * interpolation. A larger table has a lower THD at the cost of cache/memory
+ * footprint (the table size is 8 << COS_LUT_BITS bytes). The default 7-bit
+ * table is stored in read-only memory, other sizes are built by lut_init().
  */
 
+#ifndef COS_LUT_BITS
 #define COS_LUT_BITS (7U)
+#endif
+
+#if (COS_LUT_BITS < 7) || (COS_LUT_BITS > 12)
+#error "COS_LUT_BITS must be 7..12"
+#endif
+
 #define COS_LUT_SIZE (1U << COS_LUT_BITS)
 
+/* q15 (y, dy) pairs, built from the float table by lut_init() */
+static q15_t COS_LUT_q15[COS_LUT_SIZE << 1];
+
+static void cos_lut_init_q15(void);
+
+#if COS_LUT_BITS == 7
+
+/* generated by ./tools/lut.py */
 static const float COS_LUT_data[COS_LUT_SIZE << 1] = {
 	1.000000e+00, -1.204544e-03, 9.987955e-01, -3.610730e-03, 9.951847e-01, -6.008217e-03, 9.891765e-01, -8.391230e-03,
 	9.807853e-01, -1.075403e-02, 9.700313e-01, -1.309092e-02, 9.569403e-01, -1.539627e-02, 9.415441e-01, -1.766453e-02,
@@ -48,6 +72,37 @@ static const float COS_LUT_data[COS_LUT_SIZE << 1] = {
 	9.807853e-01, 8.391230e-03, 9.891765e-01, 6.008217e-03, 9.951847e-01, 3.610730e-03, 9.987955e-01, 1.204544e-03,
 };
 
+/* lut_init builds any lookup tables that are not stored in read-only memory */
+void lut_init(void) {
+	cos_lut_init_q15();
+}
+
+#else
+
+static float COS_LUT_data[COS_LUT_SIZE << 1];
+
+/* lut_init builds any lookup tables that are not stored in read-only memory */
+void lut_init(void) {
+	/* cos/sin of the angular step */
+	double c, s;
+	cos_sin_small(2.0 * 3.14159265358979323846 / (double)COS_LUT_SIZE, &c, &s);
+	/* rotate around the unit circle */
+	double y0 = 1.0;
+	double y1 = 0.0;
+
+	for (size_t i = 0; i < COS_LUT_SIZE; i++) {
+		double y0_next = (y0 * c) - (y1 * s);
+		double y1_next = (y0 * s) + (y1 * c);
+		COS_LUT_data[i << 1] = (float)y0;
+		COS_LUT_data[(i << 1) + 1] = (float)(y0_next - y0);
+		y0 = y0_next;
+		y1 = y1_next;
+	}
+	cos_lut_init_q15();
+}
+
+#endif
+
 #define FRAC_BITS (32U - COS_LUT_BITS)
 #define FRAC_MASK ((1U << FRAC_BITS) - 1)
 #define FRAC_SCALE (1.f / (float)FRAC_MASK)
@@ -61,6 +116,77 @@ float cos_lookup(uint32_t x) {
 	return y + (dy * frac);
 }
 
+#if defined(__AVX2__)
+
+/* cos_lookup_block returns cos_lookup() for a block of phase values */
+void cos_lookup_block(const uint32_t * x, float *out) {
+	const __m256i mask = _mm256_set1_epi32(FRAC_MASK);
+	const __m256 scale = _mm256_set1_ps(FRAC_SCALE);
+
+	for (size_t i = 0; i < AudioBufferSize; i += 8) {
+		__m256i xi = _mm256_loadu_si256((const __m256i *)&x[i]);
+		__m256i idx = _mm256_slli_epi32(_mm256_srli_epi32(xi, FRAC_BITS), 1);
+		__m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(xi, mask)), scale);
+		__m256 y = _mm256_i32gather_ps(&COS_LUT_data[0], idx, 4);
+		__m256 dy = _mm256_i32gather_ps(&COS_LUT_data[1], idx, 4);
+		_mm256_storeu_ps(&out[i], _mm256_add_ps(y, _mm256_mul_ps(dy, frac)));
+	}
+}
+
+#else
+
+/* cos_lookup_block returns cos_lookup() for a block of phase values */
+void cos_lookup_block(const uint32_t * x, float *out) {
+	size_t n = AudioBufferSize;
+
+	/* unroll x4 so the table loads can be pipelined */
+	while (n > 0) {
+		uint32_t i0 = (x[0] >> FRAC_BITS) << 1;
+		uint32_t i1 = (x[1] >> FRAC_BITS) << 1;
+		uint32_t i2 = (x[2] >> FRAC_BITS) << 1;
+		uint32_t i3 = (x[3] >> FRAC_BITS) << 1;
+		float f0 = (x[0] & FRAC_MASK) * FRAC_SCALE;
+		float f1 = (x[1] & FRAC_MASK) * FRAC_SCALE;
+		float f2 = (x[2] & FRAC_MASK) * FRAC_SCALE;
+		float f3 = (x[3] & FRAC_MASK) * FRAC_SCALE;
+		out[0] = COS_LUT_data[i0] + (COS_LUT_data[i0 + 1] * f0);
+		out[1] = COS_LUT_data[i1] + (COS_LUT_data[i1 + 1] * f1);
+		out[2] = COS_LUT_data[i2] + (COS_LUT_data[i2 + 1] * f2);
+		out[3] = COS_LUT_data[i3] + (COS_LUT_data[i3 + 1] * f3);
+		x += 4;
+		out += 4;
+		n -= 4;
+	}
+}
+
+#endif
+
+/******************************************************************************
+ * Q15 cosine lookup
+ * For fixed point processing paths. The interpolation is integer only, so
+ * it suits targets where the float unit is the bottleneck.
+ */
+
+#define FRAC_SHIFT_Q15 (FRAC_BITS - 15U)
+
+/* cos_lut_init_q15 builds the q15 table from the float table */
+static void cos_lut_init_q15(void) {
+	for (size_t i = 0; i < (COS_LUT_SIZE << 1); i++) {
+		COS_LUT_q15[i] = float_to_q15(COS_LUT_data[i]);
+	}
+}
+
+/* cos_lookup_block_q15 returns a q15 cos_lookup() for a block of phase values */
+void cos_lookup_block_q15(const uint32_t * x, q15_t * out) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		uint32_t idx = (x[i] >> FRAC_BITS) << 1;
+		int32_t frac = (int32_t) ((x[i] & FRAC_MASK) >> FRAC_SHIFT_Q15);
+		int32_t y = COS_LUT_q15[idx];
+		int32_t dy = COS_LUT_q15[idx + 1];
+		out[i] = q15_sat(y + ((dy * frac) >> 15));
+	}
+}
+
 /******************************************************************************
  * LUT based exponential functions - generated by ./tools/exp.py
  */
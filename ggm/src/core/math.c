@@ -128,6 +128,20 @@ float tanf(float x) {
 	return sinf(x) / cosf(x);
 }
 
+/******************************************************************************
+ * Double precision rotation step
+ * cos_sin_small returns the cos/sin of a small angle (|x| <= Pi/16) using a
+ * taylor series. It doesn't depend on the cosine LUT, so it's used to build
+ * the LUT (and measure it) by stepping around the unit circle.
+ */
+
+void cos_sin_small(double x, double *c, double *s) {
+	double x2 = x * x;
+
+	*c = 1.0 - (x2 / 2.0) * (1.0 - (x2 / 12.0) * (1.0 - (x2 / 30.0) * (1.0 - (x2 / 56.0))));
+	*s = x * (1.0 - (x2 / 6.0) * (1.0 - (x2 / 20.0) * (1.0 - (x2 / 42.0) * (1.0 - (x2 / 72.0)))));
+}
+
 /******************************************************************************
  * 32-bit float power function
  * powe returns powf(e, x)
@@ -8,13 +8,75 @@
 
 #include "ggm.h"
 
+/******************************************************************************
+ * Note frequencies
+ * The integer note frequencies come from a 128 entry table. By default this
+ * is 12-TET (A4 = 440 Hz), but it can be replaced with a microtuning table.
+ * Fractional notes (pitch bend, fine tuning) scale the table value by a
+ * semitone ratio, and a pitch bend applied to many notes can compute that
+ * ratio once with midi_bend_ratio().
+ */
+
+/* equal temperament note frequencies, 440 * 2^((n - 69) / 12) */
+static const float midi_note_et[128] = {
+	8.175799e+00, 8.661957e+00, 9.177024e+00, 9.722718e+00, 1.030086e+01, 1.091338e+01, 1.156233e+01, 1.224986e+01,
+	1.297827e+01, 1.375000e+01, 1.456762e+01, 1.543385e+01, 1.635160e+01, 1.732391e+01, 1.835405e+01, 1.944544e+01,
+	2.060172e+01, 2.182676e+01, 2.312465e+01, 2.449971e+01, 2.595654e+01, 2.750000e+01, 2.913524e+01, 3.086771e+01,
+	3.270320e+01, 3.464783e+01, 3.670810e+01, 3.889087e+01, 4.120344e+01, 4.365353e+01, 4.624930e+01, 4.899943e+01,
+	5.191309e+01, 5.500000e+01, 5.827047e+01, 6.173541e+01, 6.540639e+01, 6.929566e+01, 7.341619e+01, 7.778175e+01,
+	8.240689e+01, 8.730706e+01, 9.249861e+01, 9.799886e+01, 1.038262e+02, 1.100000e+02, 1.165409e+02, 1.234708e+02,
+	1.308128e+02, 1.385913e+02, 1.468324e+02, 1.555635e+02, 1.648138e+02, 1.746141e+02, 1.849972e+02, 1.959977e+02,
+	2.076523e+02, 2.200000e+02, 2.330819e+02, 2.469417e+02, 2.616256e+02, 2.771826e+02, 2.936648e+02, 3.111270e+02,
+	3.296276e+02, 3.492282e+02, 3.699944e+02, 3.919954e+02, 4.153047e+02, 4.400000e+02, 4.661638e+02, 4.938833e+02,
+	5.232511e+02, 5.543653e+02, 5.873295e+02, 6.222540e+02, 6.592551e+02, 6.984565e+02, 7.399888e+02, 7.839909e+02,
+	8.306094e+02, 8.800000e+02, 9.323275e+02, 9.877666e+02, 1.046502e+03, 1.108731e+03, 1.174659e+03, 1.244508e+03,
+	1.318510e+03, 1.396913e+03, 1.479978e+03, 1.567982e+03, 1.661219e+03, 1.760000e+03, 1.864655e+03, 1.975533e+03,
+	2.093005e+03, 2.217461e+03, 2.349318e+03, 2.489016e+03, 2.637020e+03, 2.793826e+03, 2.959955e+03, 3.135963e+03,
+	3.322438e+03, 3.520000e+03, 3.729310e+03, 3.951066e+03, 4.186009e+03, 4.434922e+03, 4.698636e+03, 4.978032e+03,
+	5.274041e+03, 5.587652e+03, 5.919911e+03, 6.271927e+03, 6.644875e+03, 7.040000e+03, 7.458620e+03, 7.902133e+03,
+	8.372018e+03, 8.869844e+03, 9.397273e+03, 9.956063e+03, 1.054808e+04, 1.117530e+04, 1.183982e+04, 1.254385e+04,
+};
+
+/* the current note to frequency table */
+static const float *midi_note_table = midi_note_et;
+
+/* midi_set_tuning sets a 128 entry note to frequency (Hz) table.
+ * A NULL table restores 12-TET. The table is not copied.
+ */
+void midi_set_tuning(const float *tuning) {
+	midi_note_table = (tuning == NULL) ? midi_note_et : tuning;
+}
+
+/* midi_note_frequency returns the frequency (Hz) of an integer MIDI note */
+float midi_note_frequency(uint8_t note) {
+	return midi_note_table[note & 127];
+}
+
+/* midi_bend_ratio returns the frequency ratio for a note offset (semitones) */
+float midi_bend_ratio(float bend) {
+	return pow2(bend * (1.f / 12.f));
+}
+
 /******************************************************************************
  * midi_to_frequency converts a MIDI note to a frequency value (Hz).
  * The note value is a float for pitch bending, tuning, etc.
  */
 
 float midi_to_frequency(float note) {
-	return 440.f * pow2((note - 69.f) * (1.f / 12.f));
+	float nf = truncf(note);
+	int n = (int)nf;
+
+	if ((n < 0) || (n > 127)) {
+		/* outside the table */
+		return 440.f * pow2((note - 69.f) * (1.f / 12.f));
+	}
+
+	float f = midi_note_table[n];
+	if (note != nf) {
+		/* fractional note */
+		f *= midi_bend_ratio(note - nf);
+	}
+	return f;
 }
 
 /******************************************************************************
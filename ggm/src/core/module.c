@@ -11,17 +11,22 @@
  */
 
 extern struct module_info delay_delay_module;
+extern struct module_info delay_fdn_module;
 extern struct module_info env_adsr_module;
 extern struct module_info filter_biquad_module;
+extern struct module_info filter_eq_module;
 extern struct module_info filter_svf_module;
 extern struct module_info midi_mono_module;
 extern struct module_info midi_poly_module;
 extern struct module_info mix_pan_module;
+extern struct module_info osc_fm_module;
 extern struct module_info osc_goom_module;
 extern struct module_info osc_ks_module;
 extern struct module_info osc_lfo_module;
 extern struct module_info osc_noise_module;
 extern struct module_info osc_sine_module;
+extern struct module_info osc_unison_module;
+extern struct module_info osc_wavetable_module;
 extern struct module_info pm_breath_module;
 extern struct module_info root_metro_module;
 extern struct module_info root_poly_module;
@@ -36,17 +41,22 @@ extern struct module_info view_plot_module;
 /* module_list is a list off all the system modules */
 static const struct module_info *module_list[] = {
 	&delay_delay_module,
+	&delay_fdn_module,
 	&env_adsr_module,
 	&filter_biquad_module,
+	&filter_eq_module,
 	&filter_svf_module,
 	&midi_mono_module,
 	&midi_poly_module,
 	&mix_pan_module,
+	&osc_fm_module,
 	&osc_goom_module,
 	&osc_ks_module,
 	&osc_lfo_module,
 	&osc_noise_module,
 	&osc_sine_module,
+	&osc_unison_module,
+	&osc_wavetable_module,
 	&pm_breath_module,
 	&root_metro_module,
 	&root_poly_module,
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Block Noise Generation
+ *
+ * White noise comes from NOISE_LANES independent xorshift128 generators
+ * (Marsaglia, "Xorshift RNGs", 2003). Each lane produces every NOISE_LANES-th
+ * sample, so there is no serial dependency between consecutive samples and
+ * a lane maps onto a 32-bit SIMD lane (SSE2/NEON, portable C elsewhere).
+ * The generator only needs shifts and xors.
+ *
+ * The pink noise filters are Paul Kellet's parallel one-pole sections
+ * (http://www.musicdsp.org/files/pink.txt). The sections are independent, so
+ * they are run as lanes that are summed for each output sample.
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ * seeding
+ */
+
+/* noise_hash returns a well mixed 32-bit value (murmur3 finalizer) */
+static uint32_t noise_hash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85ebca6b;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35;
+	x ^= x >> 16;
+	return x;
+}
+
+/* noise_gen_init seeds the generator lanes and clears the filter state */
+void noise_gen_init(struct noise_gen *g, uint32_t seed) {
+	uint32_t k = seed * (4 * NOISE_LANES);
+
+	memset(g, 0, sizeof(struct noise_gen));
+	for (int i = 0; i < NOISE_LANES; i++) {
+		g->x[i] = noise_hash(k++);
+		g->y[i] = noise_hash(k++);
+		g->z[i] = noise_hash(k++);
+		/* the state must not be all zero */
+		g->w[i] = noise_hash(k++) | 1;
+	}
+}
+
+/******************************************************************************
+ * white noise
+ */
+
+/* noise_gen_white fills out with white noise -1..1 */
+void noise_gen_white(struct noise_gen *g, float *out, size_t n) {
+#if defined(__SSE2__)
+	__m128i x = _mm_loadu_si128((__m128i *) g->x);
+	__m128i y = _mm_loadu_si128((__m128i *) g->y);
+	__m128i z = _mm_loadu_si128((__m128i *) g->z);
+	__m128i w = _mm_loadu_si128((__m128i *) g->w);
+	const __m128i one = _mm_set1_epi32(0x40000000);	/* 2.f */
+	const __m128 three = _mm_set1_ps(3.f);
+
+	for (size_t i = 0; i < n; i += NOISE_LANES) {
+		__m128i t = _mm_xor_si128(x, _mm_slli_epi32(x, 11));
+		x = y;
+		y = z;
+		z = w;
+		w = _mm_xor_si128(_mm_xor_si128(w, _mm_srli_epi32(w, 19)), _mm_xor_si128(t, _mm_srli_epi32(t, 8)));
+		/* 23 random mantissa bits with the exponent of 2.f gives 2..4 */
+		__m128i f = _mm_or_si128(_mm_srli_epi32(w, 9), one);
+		_mm_storeu_ps(&out[i], _mm_sub_ps(_mm_castsi128_ps(f), three));
+	}
+
+	_mm_storeu_si128((__m128i *) g->x, x);
+	_mm_storeu_si128((__m128i *) g->y, y);
+	_mm_storeu_si128((__m128i *) g->z, z);
+	_mm_storeu_si128((__m128i *) g->w, w);
+#elif defined(__ARM_NEON)
+	uint32x4_t x = vld1q_u32(g->x);
+	uint32x4_t y = vld1q_u32(g->y);
+	uint32x4_t z = vld1q_u32(g->z);
+	uint32x4_t w = vld1q_u32(g->w);
+	const uint32x4_t one = vdupq_n_u32(0x40000000);	/* 2.f */
+	const float32x4_t three = vdupq_n_f32(3.f);
+
+	for (size_t i = 0; i < n; i += NOISE_LANES) {
+		uint32x4_t t = veorq_u32(x, vshlq_n_u32(x, 11));
+		x = y;
+		y = z;
+		z = w;
+		w = veorq_u32(veorq_u32(w, vshrq_n_u32(w, 19)), veorq_u32(t, vshrq_n_u32(t, 8)));
+		/* 23 random mantissa bits with the exponent of 2.f gives 2..4 */
+		uint32x4_t f = vorrq_u32(vshrq_n_u32(w, 9), one);
+		vst1q_f32(&out[i], vsubq_f32(vreinterpretq_f32_u32(f), three));
+	}
+
+	vst1q_u32(g->x, x);
+	vst1q_u32(g->y, y);
+	vst1q_u32(g->z, z);
+	vst1q_u32(g->w, w);
+#else
+	union {
+		uint32_t ui;
+		float f;
+	} val;
+
+	for (size_t i = 0; i < n; i += NOISE_LANES) {
+		for (int j = 0; j < NOISE_LANES; j++) {
+			uint32_t t = g->x[j] ^ (g->x[j] << 11);
+			g->x[j] = g->y[j];
+			g->y[j] = g->z[j];
+			g->z[j] = g->w[j];
+			g->w[j] = g->w[j] ^ (g->w[j] >> 19) ^ (t ^ (t >> 8));
+			/* 23 random mantissa bits with the exponent of 2.f gives 2..4 */
+			val.ui = (g->w[j] >> 9) | 0x40000000;
+			out[i + j] = val.f - 3.f;
+		}
+	}
+#endif
+}
+
+/******************************************************************************
+ * coloured noise
+ * The output scaling is folded into the filter coefficients.
+ */
+
+/* noise_gen_brown fills out with brown noise */
+void noise_gen_brown(struct noise_gen *g, float *out, size_t n) {
+	float b0 = g->brown;
+
+	noise_gen_white(g, out, n);
+	for (size_t i = 0; i < n; i++) {
+		b0 = (b0 + (0.02f * out[i])) * (1.0f / 1.02f);
+		out[i] = b0 * (1.0f / 0.38f);
+	}
+	g->brown = b0;
+}
+
+/* pink1 sections: 3 one-poles and the direct term */
+static const float pink1_a[NOISE_LANES] = {
+	0.99765f, 0.96300f, 0.57000f, 0.f,
+};
+
+static const float pink1_g[NOISE_LANES] = {
+	0.0990460f / 10.4f, 0.2965164f / 10.4f, 1.0526913f / 10.4f, 0.1848f / 10.4f,
+};
+
+/* noise_gen_pink1 fills out with pink noise (low quality) */
+void noise_gen_pink1(struct noise_gen *g, float *out, size_t n) {
+	float b[NOISE_LANES];
+
+	memcpy(b, g->b, sizeof(b));
+	noise_gen_white(g, out, n);
+	for (size_t i = 0; i < n; i++) {
+		float white = out[i];
+		float pink = 0.f;
+		for (int j = 0; j < NOISE_LANES; j++) {
+			b[j] = (pink1_a[j] * b[j]) + (pink1_g[j] * white);
+			pink += b[j];
+		}
+		out[i] = pink;
+	}
+	memcpy(g->b, b, sizeof(b));
+}
+
+/* pink2 sections: 6 one-poles, the direct term and an unused lane */
+static const float pink2_a[2 * NOISE_LANES] = {
+	0.99886f, 0.99332f, 0.96900f, 0.86650f, 0.55000f, -0.7616f, 0.f, 0.f,
+};
+
+static const float pink2_g[2 * NOISE_LANES] = {
+	0.0555179f / 10.2f, 0.0750759f / 10.2f, 0.1538520f / 10.2f, 0.3104856f / 10.2f,
+	0.5329522f / 10.2f, -0.0168980f / 10.2f, 0.5362f / 10.2f, 0.f,
+};
+
+/* noise_gen_pink2 fills out with pink noise (higher quality) */
+void noise_gen_pink2(struct noise_gen *g, float *out, size_t n) {
+	float b[2 * NOISE_LANES];
+	float b6 = g->b6;
+
+	memcpy(b, g->b, sizeof(b));
+	noise_gen_white(g, out, n);
+	for (size_t i = 0; i < n; i++) {
+		float white = out[i];
+		float pink = b6;
+		for (int j = 0; j < 2 * NOISE_LANES; j++) {
+			b[j] = (pink2_a[j] * b[j]) + (pink2_g[j] * white);
+			pink += b[j];
+		}
+		b6 = white * (0.115926f / 10.2f);
+		out[i] = pink;
+	}
+	memcpy(g->b, b, sizeof(b));
+	g->b6 = b6;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,201 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * 2x/4x Oversampling
+ *
+ * Modules that generate or process aliasing-prone signals can opt in to
+ * oversampling. They run their kernel over factor * AudioBufferSize samples
+ * at factor * AudioSampleFrequency and use these functions to convert to and
+ * from the base rate.
+ *
+ * Each 2x stage is a polyphase halfband FIR (Kaiser windowed sinc). Every
+ * second coefficient of a halfband filter is zero and the rest are symmetric,
+ * so a stage costs one multiply per coefficient pair per base rate sample.
+ * The filter is evaluated one coefficient pair at a time across the whole
+ * block, so the inner loop is a SIMD friendly multiply-accumulate.
+ *
+ * The 1x/2x stage has a 20 kHz passband and > 80 dB stopband rejection from
+ * 28 kHz. The 2x/4x stage has a much wider transition band so it's shorter.
+ *
+ * Modules with several outputs allocate a decimator per output channel. The
+ * decimators are streaming, so a module can also process and decimate its
+ * oversampled signal in parts with oversample_down_ch().
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ * halfband filter coefficients
+ * The non-zero coefficients for one side of the filter, from the outermost
+ * to the innermost. The center coefficient is 0.5.
+ */
+
+/* 1x/2x stage: 63 taps, kaiser beta = 8 */
+#define HB0_PAIRS 16
+static const float hb0_coeffs[HB0_PAIRS] = {
+	-5.415090e-05, 1.715712e-04, -4.022942e-04, 8.066686e-04, -1.461882e-03, 2.463970e-03, -3.931325e-03, 6.012098e-03,
+	-8.900342e-03, 1.287138e-02, -1.836152e-02, 2.616076e-02, -3.794316e-02, 5.807584e-02, -1.026663e-01, 3.171543e-01,
+};
+
+/* 2x/4x stage: 23 taps, kaiser beta = 8 */
+#define HB1_PAIRS 6
+static const float hb1_coeffs[HB1_PAIRS] = {
+	-3.880650e-04, 2.926225e-03, -1.128202e-02, 3.231497e-02, -8.368644e-02, 3.101237e-01,
+};
+
+/******************************************************************************
+ * halfband filter
+ */
+
+/* hb_mac does y[i] += g * (a[i] + b[i]) for n (a multiple of 4) samples */
+static void hb_mac(float *y, const float *a, const float *b, float g, size_t n) {
+#if defined(__SSE2__)
+	__m128 gx = _mm_set1_ps(g);
+	for (size_t i = 0; i < n; i += 4) {
+		__m128 s = _mm_add_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i]));
+		_mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(s, gx)));
+	}
+#elif defined(__ARM_NEON)
+	for (size_t i = 0; i < n; i += 4) {
+		float32x4_t s = vaddq_f32(vld1q_f32(&a[i]), vld1q_f32(&b[i]));
+		vst1q_f32(&y[i], vmlaq_n_f32(vld1q_f32(&y[i]), s, g));
+	}
+#else
+	for (size_t i = 0; i < n; i++) {
+		y[i] += g * (a[i] + b[i]);
+	}
+#endif
+}
+
+/* hb_fir evaluates the symmetric coefficients of a halfband filter.
+ * x has (2 * pairs) - 1 samples of history followed by n new samples.
+ * y[i] = sum(g[j] * (x[i + j] + x[i + h - j])), h = (2 * pairs) - 1
+ */
+static void hb_fir(float *y, const float *x, const float *g, int pairs, size_t n) {
+	int h = (2 * pairs) - 1;
+
+	memset(y, 0, n * sizeof(float));
+	for (int j = 0; j < pairs; j++) {
+		hb_mac(y, &x[j], &x[h - j], g[j], n);
+	}
+}
+
+/* hb_up upsamples n input samples to 2n output samples */
+static void hb_up(struct oversample *os, struct halfband *hb, const float *g, int pairs, const float *in, float *out, size_t n) {
+	int h = (2 * pairs) - 1;
+	float *x = os->w0;
+	float *y = os->w1;
+
+	/* history + input */
+	memcpy(x, hb->z0, h * sizeof(float));
+	memcpy(&x[h], in, n * sizeof(float));
+
+	/* even outputs are filtered, odd outputs are the (delayed) input */
+	hb_fir(y, x, g, pairs, n);
+	for (size_t i = 0; i < n; i++) {
+		out[2 * i] = 2.f * y[i];
+		out[(2 * i) + 1] = x[i + pairs];
+	}
+
+	/* update the history */
+	memcpy(hb->z0, &x[n], h * sizeof(float));
+}
+
+/* hb_down decimates 2n input samples to n output samples */
+static void hb_down(struct oversample *os, struct halfband *hb, const float *g, int pairs, const float *in, float *out, size_t n) {
+	int h = (2 * pairs) - 1;
+	float *xe = os->w0;
+	float *xo = os->w1;
+
+	/* history + split the input into even and odd phases */
+	memcpy(xe, hb->z0, h * sizeof(float));
+	memcpy(xo, hb->z1, pairs * sizeof(float));
+	for (size_t i = 0; i < n; i++) {
+		xe[h + i] = in[2 * i];
+		xo[pairs + i] = in[(2 * i) + 1];
+	}
+
+	/* the even phase is filtered, the odd phase is the center tap */
+	hb_fir(out, xe, g, pairs, n);
+	for (size_t i = 0; i < n; i++) {
+		out[i] += 0.5f * xo[i];
+	}
+
+	/* update the history */
+	memcpy(hb->z0, &xe[n], h * sizeof(float));
+	memcpy(hb->z1, &xo[n], pairs * sizeof(float));
+}
+
+/******************************************************************************
+ * oversampler
+ */
+
+/* oversample_new returns a new oversampler (factor = 2 or 4) with
+ * decimators for a number of output channels.
+ */
+struct oversample *oversample_new(int factor, int channels) {
+	if ((factor != 2) && (factor != 4)) {
+		LOG_ERR("bad oversampling factor %d", factor);
+		return NULL;
+	}
+	if (channels < 1) {
+		LOG_ERR("bad number of channels %d", channels);
+		return NULL;
+	}
+
+	struct oversample *os = ggm_calloc(1, sizeof(struct oversample) + (channels * sizeof(os->down[0])));
+	if (os == NULL) {
+		return NULL;
+	}
+	os->factor = factor;
+	os->channels = channels;
+	return os;
+}
+
+/* oversample_del deallocates an oversampler */
+void oversample_del(struct oversample *os) {
+	ggm_free(os);
+}
+
+/* oversample_up upsamples a block of AudioBufferSize samples.
+ * It returns the oversampled buffer (factor * AudioBufferSize samples).
+ * Modules generating a signal can write to os->buf directly.
+ */
+float *oversample_up(struct oversample *os, const float *in) {
+	if (os->factor == 2) {
+		hb_up(os, &os->up[0], hb0_coeffs, HB0_PAIRS, in, os->buf, AudioBufferSize);
+	} else {
+		hb_up(os, &os->up[0], hb0_coeffs, HB0_PAIRS, in, os->mid, AudioBufferSize);
+		hb_up(os, &os->up[1], hb1_coeffs, HB1_PAIRS, os->mid, os->buf, 2 * AudioBufferSize);
+	}
+	return os->buf;
+}
+
+/* oversample_down_ch decimates (factor * n) samples to n samples (n is a
+ * multiple of 4, <= AudioBufferSize) for an output channel.
+ */
+void oversample_down_ch(struct oversample *os, int ch, const float *in, float *out, size_t n) {
+	struct halfband *hb = os->down[ch];
+
+	if (os->factor == 2) {
+		hb_down(os, &hb[0], hb0_coeffs, HB0_PAIRS, in, out, n);
+	} else {
+		hb_down(os, &hb[1], hb1_coeffs, HB1_PAIRS, in, os->mid, 2 * n);
+		hb_down(os, &hb[0], hb0_coeffs, HB0_PAIRS, os->mid, out, n);
+	}
+}
+
+/* oversample_down decimates the oversampled buffer to AudioBufferSize samples (channel 0) */
+void oversample_down(struct oversample *os, float *out) {
+	oversample_down_ch(os, 0, os->buf, out, AudioBufferSize);
+}
+
+/*****************************************************************************/
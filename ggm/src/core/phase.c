@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Block Phase Generation
+ *
+ * A shared phase accumulator for the oscillators. Generating the phases for
+ * a block up front (4 at a time with SSE2/NEON integer adds) separates the
+ * accumulator from the wave shaping, and gives a single place to apply
+ * frequency (FM) and phase (PM) modulation.
+ *
+ * With FM each sample has its own phase step, so the phases are a running
+ * sum of the steps. The sum is done 4 samples at a time with a log2(4) step
+ * prefix sum within a vector and a running total across vectors.
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* PHASE_STEP_MAX is the largest modulation phase step (just under HalfCycle) */
+#define PHASE_STEP_MAX (2147483520.f)
+
+/******************************************************************************
+ * phase generators
+ */
+
+/* phase_gen writes the phases for n samples with a fixed phase step */
+void phase_gen(uint32_t * out, uint32_t * x, uint32_t xstep, size_t n) {
+	uint32_t x0 = *x;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128i step = _mm_set1_epi32((int)(4 * xstep));
+	__m128i xi = _mm_add_epi32(_mm_set1_epi32((int)x0), _mm_setr_epi32(0, (int)xstep, (int)(2 * xstep), (int)(3 * xstep)));
+
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128((__m128i *) & out[i], xi);
+		xi = _mm_add_epi32(xi, step);
+	}
+#elif defined(__ARM_NEON)
+	const uint32x4_t step = vdupq_n_u32(4 * xstep);
+	const uint32_t x4[4] = { x0, x0 + xstep, x0 + (2 * xstep), x0 + (3 * xstep), };
+	uint32x4_t xi = vld1q_u32(x4);
+
+	for (; i + 4 <= n; i += 4) {
+		vst1q_u32(&out[i], xi);
+		xi = vaddq_u32(xi, step);
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = x0 + ((uint32_t) i * xstep);
+	}
+	*x = x0 + ((uint32_t) n * xstep);
+}
+
+/* phase_gen_fm writes the phases for n samples with frequency modulation.
+ * The phase step for each sample is xstep + (fm[i] * k). For fm in Hz, k is
+ * the phase step per Hz (FrequencyScale at the base sample rate).
+ */
+void phase_gen_fm(uint32_t * out, uint32_t * x, uint32_t xstep, const float *fm, float k, size_t n) {
+	uint32_t acc = *x;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 kx = _mm_set1_ps(k);
+	const __m128 hi = _mm_set1_ps(PHASE_STEP_MAX);
+	const __m128 lo = _mm_set1_ps(-PHASE_STEP_MAX);
+	const __m128i base = _mm_set1_epi32((int)xstep);
+	__m128i ax = _mm_set1_epi32((int)acc);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 d = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&fm[i]), kx), lo), hi);
+		__m128i s = _mm_add_epi32(_mm_cvttps_epi32(d), base);
+		/* inclusive prefix sum of the steps */
+		__m128i p = _mm_add_epi32(s, _mm_slli_si128(s, 4));
+		p = _mm_add_epi32(p, _mm_slli_si128(p, 8));
+		/* the phase of a sample excludes its own step */
+		_mm_storeu_si128((__m128i *) & out[i], _mm_add_epi32(ax, _mm_sub_epi32(p, s)));
+		ax = _mm_add_epi32(ax, _mm_shuffle_epi32(p, 0xff));
+	}
+	acc = (uint32_t) _mm_cvtsi128_si32(ax);
+#elif defined(__ARM_NEON)
+	const uint32x4_t zero = vdupq_n_u32(0);
+	const uint32x4_t base = vdupq_n_u32(xstep);
+	uint32x4_t ax = vdupq_n_u32(acc);
+
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t d = vmulq_n_f32(vld1q_f32(&fm[i]), k);
+		d = vminq_f32(vmaxq_f32(d, vdupq_n_f32(-PHASE_STEP_MAX)), vdupq_n_f32(PHASE_STEP_MAX));
+		uint32x4_t s = vaddq_u32(vreinterpretq_u32_s32(vcvtq_s32_f32(d)), base);
+		/* inclusive prefix sum of the steps */
+		uint32x4_t p = vaddq_u32(s, vextq_u32(zero, s, 3));
+		p = vaddq_u32(p, vextq_u32(zero, p, 2));
+		/* the phase of a sample excludes its own step */
+		vst1q_u32(&out[i], vaddq_u32(ax, vsubq_u32(p, s)));
+		ax = vaddq_u32(ax, vdupq_n_u32(vgetq_lane_u32(p, 3)));
+	}
+	acc = vgetq_lane_u32(ax, 0);
+#endif
+	for (; i < n; i++) {
+		float d = clampf(fm[i] * k, -PHASE_STEP_MAX, PHASE_STEP_MAX);
+		out[i] = acc;
+		acc += xstep + (uint32_t) (int32_t) d;
+	}
+	*x = acc;
+}
+
+/* phase_gen_pm adds phase modulation (radians) to n phases */
+void phase_gen_pm(uint32_t * out, const float *pm, size_t n) {
+	const float k = 1.f / Tau;
+	size_t i = 0;
+
+	/* The offset is reduced to -1..1 cycles and scaled to +/- HalfCycle so
+	 * it converts to an int32_t, then doubled to a full phase offset.
+	 */
+#if defined(__SSE2__)
+	const __m128 kx = _mm_set1_ps(k);
+	const __m128 half = _mm_set1_ps((float)HalfCycle);
+
+	for (; i + 4 <= n; i += 4) {
+		__m128 c = _mm_mul_ps(_mm_loadu_ps(&pm[i]), kx);
+		c = _mm_sub_ps(c, _mm_cvtepi32_ps(_mm_cvttps_epi32(c)));
+		__m128i d = _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(c, half)), 1);
+		__m128i *p = (__m128i *) & out[i];
+		_mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), d));
+	}
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t c = vmulq_n_f32(vld1q_f32(&pm[i]), k);
+		c = vsubq_f32(c, vcvtq_f32_s32(vcvtq_s32_f32(c)));
+		int32x4_t d = vshlq_n_s32(vcvtq_s32_f32(vmulq_n_f32(c, (float)HalfCycle)), 1);
+		vst1q_u32(&out[i], vaddq_u32(vld1q_u32(&out[i]), vreinterpretq_u32_s32(d)));
+	}
+#endif
+	for (; i < n; i++) {
+		float c = pm[i] * k;
+		c -= truncf(c);
+		out[i] += (uint32_t) (int32_t) (c * (float)HalfCycle) << 1;
+	}
+}
+
+/* phase_gen_mod writes the phases for n samples with optional FM (Hz, scaled
+ * by k) and PM (radians) buffers. A NULL buffer means no modulation.
+ */
+void phase_gen_mod(uint32_t * out, uint32_t * x, uint32_t xstep, const float *fm, const float *pm, float k, size_t n) {
+	if (fm != NULL) {
+		phase_gen_fm(out, x, xstep, fm, k, n);
+	} else {
+		phase_gen(out, x, xstep, n);
+	}
+	if (pm != NULL) {
+		phase_gen_pm(out, pm, n);
+	}
+}
+
+/*****************************************************************************/
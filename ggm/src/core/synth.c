@@ -75,6 +75,10 @@ struct synth *synth_new(void) {
 		return NULL;
 	}
 	LOG_INF("synth (%d bytes)", sizeof(struct synth));
+
+	/* build the lookup tables */
+	lut_init();
+
 	return s;
 }
 
@@ -91,6 +95,7 @@ void synth_del(struct synth *s) {
 
 	/* free the allocated audio buffers */
 	ggm_free(s->bufs[0]);
+	ggm_free(s->noise.buf);
 	ggm_free(s);
 }
 
@@ -412,6 +417,9 @@ bool synth_loop(struct synth *s) {
 	/* run the buffer processing */
 	bool active = m->info->process(m, s->bufs);
 
+	/* new noise for the next buffer */
+	s->noise.valid = false;
+
 	/* process all queued events */
 	while (synth_event_rd(s, &q) == 0) {
 		event_out(q.m, q.idx, &q.e);
@@ -420,4 +428,83 @@ bool synth_loop(struct synth *s) {
 	return active;
 }
 
+/******************************************************************************
+ * shared noise bus
+ * Modules that need white noise subscribe to the bus and get a stream index.
+ * The first read in a buffer period generates the streams up to the highest
+ * subscribed index, so every subscriber has its own independent stream.
+ * Stream buffers are allocated NOISE_BUS_STREAMS at a time as needed.
+ */
+
+/* noise_bus_streams updates the number of streams to generate */
+static void noise_bus_streams(struct noise_bus *nb) {
+	int n = 0;
+
+	for (int i = 0; i < NOISE_BUS_MAX_STREAMS; i++) {
+		if (nb->used & (1U << i)) {
+			n = i + 1;
+		}
+	}
+	nb->streams = n;
+}
+
+/* synth_noise_subscribe returns a noise stream index (< 0 on error) */
+int synth_noise_subscribe(struct synth *s) {
+	struct noise_bus *nb = &s->noise;
+	int idx = 0;
+
+	/* find a free stream */
+	while ((idx < NOISE_BUS_MAX_STREAMS) && (nb->used & (1U << idx))) {
+		idx++;
+	}
+	if (idx == NOISE_BUS_MAX_STREAMS) {
+		LOG_ERR("no free noise streams");
+		return -1;
+	}
+
+	/* grow the stream buffers */
+	if (idx >= nb->size) {
+		int size = nb->size + NOISE_BUS_STREAMS;
+		float *buf = ggm_calloc(size * AudioBufferSize, sizeof(float));
+		if (buf == NULL) {
+			LOG_ERR("could not allocate noise bus");
+			return -1;
+		}
+		if (nb->buf == NULL) {
+			noise_gen_init(&nb->gen, 0);
+		}
+		/* the streams are regenerated on the next read */
+		ggm_free(nb->buf);
+		nb->buf = buf;
+		nb->size = size;
+		nb->valid = false;
+	}
+
+	nb->used |= (1U << idx);
+	noise_bus_streams(nb);
+	return idx;
+}
+
+/* synth_noise_unsubscribe releases a noise stream index */
+void synth_noise_unsubscribe(struct synth *s, int idx) {
+	struct noise_bus *nb = &s->noise;
+
+	if ((idx < 0) || (idx >= NOISE_BUS_MAX_STREAMS)) {
+		return;
+	}
+	nb->used &= ~(1U << idx);
+	noise_bus_streams(nb);
+}
+
+/* synth_noise copies a buffer of white noise for a stream index to out */
+void synth_noise(struct synth *s, int idx, float *out) {
+	struct noise_bus *nb = &s->noise;
+
+	if (!nb->valid) {
+		noise_gen_white(&nb->gen, nb->buf, nb->streams * AudioBufferSize);
+		nb->valid = true;
+	}
+	memcpy(out, &nb->buf[idx * AudioBufferSize], AudioBufferSize * sizeof(float));
+}
+
 /*****************************************************************************/
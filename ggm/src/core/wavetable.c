@@ -0,0 +1,236 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Band-limited Wavetables
+ *
+ * A single cycle waveform is held as a set of band-limited mip levels. Level
+ * n holds (WT_SIZE >> (n + 3)) harmonics, so each level is an octave below
+ * the previous one and every level is at least 4x oversampled for linear
+ * interpolation. The level is picked once per block so that the highest
+ * harmonic is below the nyquist frequency.
+ *
+ * The mip levels are built by additive synthesis when the first oscillator
+ * using a shape gets the table, and are shared read-only between all the
+ * oscillators using that shape. User waveforms (e.g. loaded from a file by
+ * the application) are analysed with a DFT and rebuilt in the same way.
+ */
+
+#include "ggm.h"
+
+/******************************************************************************
+ * mip levels
+ */
+
+#define WT_MIN_BITS 6		/* log2 of the smallest mip level size */
+#define WT_LEVELS (WT_BITS - 2)	/* number of mip levels */
+
+struct wt_table {
+	struct wt_table *next;	/* list of shared tables */
+	int shape;		/* wave shape */
+	const float *src;	/* user waveform */
+	int refs;		/* reference count */
+	float *level[WT_LEVELS];	/* mip level tables */
+};
+
+/* wt_list is the list of allocated tables */
+static struct wt_table *wt_list;
+
+/* wt_bits returns the log2 size of a mip level */
+static unsigned int wt_bits(int level) {
+	int bits = WT_BITS - level;
+
+	return (bits < WT_MIN_BITS) ? WT_MIN_BITS : bits;
+}
+
+/* wt_harmonics returns the number of harmonics in a mip level */
+static unsigned int wt_harmonics(int level) {
+	return WT_SIZE >> (level + 3);
+}
+
+/* wt_level returns the mip level for a phase step */
+static int wt_level(uint32_t xstep) {
+	for (int i = 0; i < WT_LEVELS - 1; i++) {
+		/* is the highest harmonic below the nyquist frequency? */
+		if ((uint64_t) wt_harmonics(i) * xstep <= HalfCycle) {
+			return i;
+		}
+	}
+	return WT_LEVELS - 1;
+}
+
+/* wt_coeffs sets the cosine (a) and sine (b) harmonic coefficients of a shape */
+static void wt_coeffs(int shape, const float *src, float *a, float *b, unsigned int n) {
+	for (unsigned int k = 1; k < n; k++) {
+		float odd = (float)(k & 1);
+		switch (shape) {
+		case WAVETABLE_SHAPE_SAW:
+			b[k] = ((k & 1) ? 2.f : -2.f) / (Pi * (float)k);
+			break;
+		case WAVETABLE_SHAPE_SQUARE:
+			b[k] = odd * 4.f / (Pi * (float)k);
+			break;
+		case WAVETABLE_SHAPE_TRIANGLE:
+			b[k] = odd * ((k & 2) ? -8.f : 8.f) / (Pi * Pi * (float)(k * k));
+			break;
+		case WAVETABLE_SHAPE_USER:{
+				/* dft of the user waveform */
+				float ak = 0.f;
+				float bk = 0.f;
+				for (unsigned int i = 0; i < WT_SIZE; i++) {
+					uint32_t x = (uint32_t) (k * i) << (32 - WT_BITS);
+					ak += src[i] * cos_lookup(x);
+					bk += src[i] * cos_lookup(x - QuarterCycle);
+				}
+				a[k] = ak * (2.f / (float)WT_SIZE);
+				b[k] = bk * (2.f / (float)WT_SIZE);
+				break;
+			}
+		}
+	}
+	if (shape == WAVETABLE_SHAPE_USER) {
+		/* dc offset */
+		float dc = 0.f;
+		for (unsigned int i = 0; i < WT_SIZE; i++) {
+			dc += src[i];
+		}
+		a[0] = dc * (1.f / (float)WT_SIZE);
+	}
+}
+
+/* wt_build builds the mip levels for a table */
+static int wt_build(struct wt_table *t) {
+	unsigned int n = wt_harmonics(0) + 1;
+	size_t size = 0;
+
+	/* allocate the mip levels (with a guard sample for interpolation) */
+	for (int i = 0; i < WT_LEVELS; i++) {
+		size += (1U << wt_bits(i)) + 1;
+	}
+	float *buf = ggm_calloc(size, sizeof(float));
+	if (buf == NULL) {
+		return -1;
+	}
+
+	/* harmonic coefficients */
+	float *a = ggm_calloc(2 * n, sizeof(float));
+	if (a == NULL) {
+		ggm_free(buf);
+		return -1;
+	}
+	float *b = &a[n];
+	wt_coeffs(t->shape, t->src, a, b, n);
+
+	/* additive synthesis of each level */
+	float peak = 0.f;
+	for (int i = 0; i < WT_LEVELS; i++) {
+		unsigned int bits = wt_bits(i);
+		unsigned int h = wt_harmonics(i);
+		t->level[i] = buf;
+		for (unsigned int j = 0; j < (1U << bits); j++) {
+			float y = a[0];
+			for (unsigned int k = 1; k <= h; k++) {
+				uint32_t x = (uint32_t) (k * j) << (32 - bits);
+				y += (a[k] * cos_lookup(x)) + (b[k] * cos_lookup(x - QuarterCycle));
+			}
+			buf[j] = y;
+			if ((i == 0) && (fabsf(y) > peak)) {
+				peak = fabsf(y);
+			}
+		}
+		buf[1U << bits] = buf[0];
+		buf += (1U << bits) + 1;
+	}
+	ggm_free(a);
+
+	/* normalise the levels to the peak of the first level */
+	if (peak > 0.f) {
+		float k = 1.f / peak;
+		float *x = t->level[0];
+		for (size_t i = 0; i < size; i++) {
+			x[i] *= k;
+		}
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ * shared tables
+ */
+
+/* wt_get returns a reference to the shared table for a shape */
+struct wt_table *wt_get(int shape, const float *src) {
+	struct wt_table *t;
+
+	/* do we have this table? */
+	for (t = wt_list; t != NULL; t = t->next) {
+		if ((t->shape == shape) && (t->src == src)) {
+			t->refs++;
+			return t;
+		}
+	}
+
+	/* build a new table */
+	t = ggm_calloc(1, sizeof(struct wt_table));
+	if (t == NULL) {
+		return NULL;
+	}
+	t->shape = shape;
+	t->src = src;
+	if (wt_build(t) < 0) {
+		ggm_free(t);
+		return NULL;
+	}
+	LOG_INF("built wavetable shape %d", shape);
+
+	/* add it to the list */
+	t->refs = 1;
+	t->next = wt_list;
+	wt_list = t;
+	return t;
+}
+
+/* wt_put releases a reference to a shared table */
+void wt_put(struct wt_table *t) {
+	if (--t->refs > 0) {
+		return;
+	}
+
+	/* remove it from the list */
+	struct wt_table **p = &wt_list;
+	while (*p != t) {
+		p = &(*p)->next;
+	}
+	*p = t->next;
+
+	/* the levels are a single allocation */
+	ggm_free(t->level[0]);
+	ggm_free(t);
+}
+
+/******************************************************************************
+ * block generation
+ */
+
+/* wt_gen generates AudioBufferSize samples for a block of phases.
+ * The mip level is picked from the phase step (xstep).
+ */
+void wt_gen(const struct wt_table *t, const uint32_t *x, uint32_t xstep, float *out) {
+	int level = wt_level(xstep);
+	const float *tbl = t->level[level];
+	unsigned int shift = 32 - wt_bits(level);
+	uint32_t mask = (1U << shift) - 1;
+	float scale = 1.f / (float)(1U << shift);
+
+	for (int i = 0; i < AudioBufferSize; i++) {
+		uint32_t idx = x[i] >> shift;
+		float frac = (float)(x[i] & mask) * scale;
+		float y0 = tbl[idx];
+		float y1 = tbl[idx + 1];
+		out[i] = y0 + (frac * (y1 - y0));
+	}
+}
+
+/*****************************************************************************/
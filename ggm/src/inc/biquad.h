@@ -0,0 +1,73 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * BiQuad Filter Design and Filter Banks
+ */
+
+#ifndef GGM_SRC_INC_BIQUAD_H
+#define GGM_SRC_INC_BIQUAD_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * biquad filter types
+ */
+
+enum {
+	BIQUAD_TYPE_NULL,
+	BIQUAD_TYPE_LPF,	/* low pass */
+	BIQUAD_TYPE_HPF,	/* high pass */
+	BIQUAD_TYPE_BPF,	/* band pass (0 dB peak gain) */
+	BIQUAD_TYPE_NOTCH,	/* notch */
+	BIQUAD_TYPE_PEAK,	/* peaking eq */
+	BIQUAD_TYPE_LOWSHELF,	/* low shelf */
+	BIQUAD_TYPE_HIGHSHELF,	/* high shelf */
+	BIQUAD_TYPE_MAX		/* must be last */
+};
+
+/******************************************************************************
+ * biquad coefficients
+ * H(z) = (a0 + a1.z^-1 + a2.z^-2) / (1 + b1.z^-1 + b2.z^-2)
+ */
+
+struct biquad_coeffs {
+	float a0, a1, a2;	/* zero coefficients */
+	float b1, b2;		/* pole coefficients */
+};
+
+void biquad_design(struct biquad_coeffs *c, int type, float cutoff, float q, float gain);
+
+/******************************************************************************
+ * biquad bank
+ * BIQUAD_LANES filter sections are run in parallel lanes. The lanes can
+ * filter independent channels, or a single channel through a cascade of
+ * sections. Lanes that have not been set pass their input through.
+ */
+
+#define BIQUAD_LANES 4
+
+struct biquad_bank {
+	float a0[BIQUAD_LANES];	/* per lane coefficients */
+	float a1[BIQUAD_LANES];
+	float a2[BIQUAD_LANES];
+	float b1[BIQUAD_LANES];
+	float b2[BIQUAD_LANES];
+	float s1[BIQUAD_LANES];	/* per lane state variables */
+	float s2[BIQUAD_LANES];
+	float pipe[BIQUAD_LANES];	/* cascade pipeline */
+};
+
+void biquad_bank_init(struct biquad_bank *bank);
+void biquad_bank_set(struct biquad_bank *bank, int lane, const struct biquad_coeffs *c);
+void biquad_bank_parallel(struct biquad_bank *bank, float *buf[BIQUAD_LANES]);
+void biquad_bank_cascade(struct biquad_bank *bank, const float *in, float *out);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_BIQUAD_H */
+
+/*****************************************************************************/
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * PolyBLEP/PolyBLAMP Corrections
+ *
+ * Naive waveforms with step (saw, square) or slope (triangle) discontinuities
+ * alias badly at higher frequencies. These functions return 2-sample
+ * polynomial residuals that are added to the naive waveform around each
+ * discontinuity to band-limit it.
+ *
+ * t = phase (0..1) of the sample relative to the discontinuity
+ * dt = phase step per sample (0 < dt <= 0.5)
+ *
+ * polyblep is the residual for a step of -2 (e.g. the saw wrap), so a step
+ * of height h is corrected with: y -= (h / -2) * polyblep(t, dt)
+ *
+ * polyblamp is the residual for a slope change of +1 per sample, so a slope
+ * change of s (per cycle) is corrected with: y += (s * dt) * polyblamp(t, dt)
+ */
+
+#ifndef GGM_SRC_INC_BLEP_H
+#define GGM_SRC_INC_BLEP_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * phase conversion
+ */
+
+/* blep_phase converts a uint32_t phase to a float 0..1 */
+static inline float blep_phase(uint32_t x) {
+	return (float)x * (1.f / (float)FullCycle);
+}
+
+/******************************************************************************
+ * corrections
+ */
+
+/* polyblep returns the band-limited step residual.
+ * The residual is -(1 - t/dt)^2 just after the discontinuity and
+ * (1 + (t - 1)/dt)^2 just before it. Both terms are clamped rather than
+ * branched on so a loop using this can be vectorized.
+ */
+static inline float polyblep(float t, float dt) {
+	float k = 1.f / dt;
+	float a = clampf_lo(1.f - t * k, 0.f);
+	float b = clampf_lo(1.f + (t - 1.f) * k, 0.f);
+	return (b * b) - (a * a);
+}
+
+/* polyblamp returns the band-limited ramp residual for a slope change of +1
+ * per sample. It's the integral of the unit step residual (1 - t/dt)^2 / 2,
+ * so it's (1 - t/dt)^3 / 6 just after the discontinuity and
+ * (1 + (t - 1)/dt)^3 / 6 just before it.
+ */
+static inline float polyblamp(float t, float dt) {
+	float k = 1.f / dt;
+	float a = clampf_lo(1.f - t * k, 0.f);
+	float b = clampf_lo(1.f + (t - 1.f) * k, 0.f);
+	return ((a * a * a) + (b * b * b)) * (1.f / 6.f);
+}
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_BLEP_H */
+
+/*****************************************************************************/
@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Delay Lines
+ */
+
+#ifndef GGM_SRC_INC_DLINE_H
+#define GGM_SRC_INC_DLINE_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * delay line interpolation types
+ */
+
+enum {
+	DLINE_INTERP_LINEAR,	/* linear (audio rate delay times) */
+	DLINE_INTERP_CUBIC,	/* 4-point hermite (audio rate delay times) */
+	DLINE_INTERP_ALLPASS,	/* 1st order allpass (fixed delay times) */
+	DLINE_INTERP_MAX	/* must be last */
+};
+
+/******************************************************************************
+ * delay line
+ * A power of 2 ring buffer. A block of samples is written and then read at
+ * one or more delays (taps). The delay for a tap is relative to each sample
+ * of the block that was just written, so a delay of 0 reads the input.
+ */
+
+struct dline {
+	float *buf;		/* ring buffer */
+	uint32_t mask;		/* ring buffer size - 1 */
+	uint32_t wr;		/* write index */
+	float max;		/* maximum delay (samples) */
+};
+
+/* state for an allpass interpolated tap */
+struct dline_allpass {
+	float y1;		/* previous output */
+};
+
+int dline_init(struct dline *d, size_t max);
+void dline_free(struct dline *d);
+void dline_clear(struct dline *d);
+void dline_write(struct dline *d, const float *in, size_t n);
+void dline_read(const struct dline *d, float *out, size_t n, size_t delay);
+void dline_read_linear(const struct dline *d, float *out, size_t n, const float *delay);
+void dline_read_cubic(const struct dline *d, float *out, size_t n, const float *delay);
+void dline_read_allpass(const struct dline *d, struct dline_allpass *ap, float *out, size_t n, float delay);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_DLINE_H */
+
+/*****************************************************************************/
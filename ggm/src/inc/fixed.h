@@ -0,0 +1,125 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Fixed Point (Q15/Q31) Types and Functions
+ */
+
+#ifndef GGM_SRC_INC_FIXED_H
+#define GGM_SRC_INC_FIXED_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * fixed point types
+ */
+
+typedef int16_t q15_t;		/* signed 1.15 fraction */
+typedef int32_t q31_t;		/* signed 1.31 fraction */
+
+#define Q15_MAX (32767)
+#define Q15_MIN (-32768)
+#define Q31_MAX (0x7fffffff)
+#define Q31_MIN (-0x7fffffff - 1)
+
+/******************************************************************************
+ * saturation
+ */
+
+/* q15_sat saturates a 32-bit value to the q15 range */
+static inline q15_t q15_sat(int32_t x) {
+	if (x > Q15_MAX) {
+		return Q15_MAX;
+	}
+	if (x < Q15_MIN) {
+		return Q15_MIN;
+	}
+	return (q15_t) x;
+}
+
+/* q31_sat saturates a 64-bit value to the q31 range */
+static inline q31_t q31_sat(int64_t x) {
+	if (x > Q31_MAX) {
+		return Q31_MAX;
+	}
+	if (x < Q31_MIN) {
+		return Q31_MIN;
+	}
+	return (q31_t) x;
+}
+
+/******************************************************************************
+ * float conversion
+ */
+
+/* float_to_q15 converts a float (-1..1) to q15 */
+static inline q15_t float_to_q15(float x) {
+	x = clampf(x, -1.f, 1.f);
+	return q15_sat((int32_t) (x * 32768.f));
+}
+
+/* q15_to_float converts a q15 to a float (-1..1) */
+static inline float q15_to_float(q15_t x) {
+	return (float)x * (1.f / 32768.f);
+}
+
+/* float_to_q31 converts a float (-1..1) to q31 */
+static inline q31_t float_to_q31(float x) {
+	x = clampf(x, -1.f, 1.f);
+	/* 1.f would overflow, so limit it to the maximum */
+	if (x == 1.f) {
+		return Q31_MAX;
+	}
+	return (q31_t) (x * 2147483648.f);
+}
+
+/* q31_to_float converts a q31 to a float (-1..1) */
+static inline float q31_to_float(q31_t x) {
+	return (float)x * (1.f / 2147483648.f);
+}
+
+/******************************************************************************
+ * arithmetic
+ */
+
+/* q15_mul multiplies two q15 values */
+static inline q15_t q15_mul(q15_t a, q15_t b) {
+	return q15_sat(((int32_t) a * (int32_t) b) >> 15);
+}
+
+/* q31_mul multiplies two q31 values (-1 * -1 saturates) */
+static inline q31_t q31_mul(q31_t a, q31_t b) {
+	return q31_sat(((int64_t) a * (int64_t) b) >> 31);
+}
+
+/* q31_add adds two q31 values with saturation */
+static inline q31_t q31_add(q31_t a, q31_t b) {
+	return q31_sat((int64_t) a + (int64_t) b);
+}
+
+/******************************************************************************
+ * function prototypes
+ */
+
+void block_zero_q15(q15_t * out);
+void block_mul_q15(q15_t * out, const q15_t * buf);
+void block_mul_k_q15(q15_t * out, q15_t k);
+void block_add_q15(q15_t * out, const q15_t * buf);
+void block_mix_q15(q15_t * out, const q15_t * a, q15_t ka, const q15_t * b, q15_t kb);
+void block_q15_to_float(float *dst, const q15_t * src);
+void block_float_to_q15(q15_t * dst, const float *src);
+
+void block_mul_q31(q31_t * out, const q31_t * buf);
+void block_mul_k_q31(q31_t * out, q31_t k);
+void block_add_q31(q31_t * out, const q31_t * buf);
+void block_q31_to_float(float *dst, const q31_t * src);
+void block_float_to_q31(q31_t * dst, const float *src);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_FIXED_H */
+
+/*****************************************************************************/
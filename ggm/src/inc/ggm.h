@@ -17,6 +17,15 @@
 
 #include "const.h"
 #include "util.h"
+#include "fixed.h"
+#include "oversample.h"
+#include "biquad.h"
+#include "dline.h"
+#include "noise.h"
+#include "phase.h"
+#include "blep.h"
+#include "goom.h"
+#include "wavetable.h"
 #include "module.h"
 #include "event.h"
 #include "port.h"
@@ -33,7 +42,10 @@
  * Lookup Table Functions
  */
 
+void lut_init(void);
 float cos_lookup(uint32_t x);
+void cos_lookup_block(const uint32_t * x, float *out);
+void cos_lookup_block_q15(const uint32_t * x, q15_t * out);
 float pow2(float x);
 
 /******************************************************************************
@@ -52,11 +64,16 @@ float tanf(float x);
 
 float powe(float x);
 
+void cos_sin_small(double x, double *c, double *s);
+
 /******************************************************************************
  * MIDI
  */
 
 float midi_to_frequency(float note);
+float midi_note_frequency(uint8_t note);
+float midi_bend_ratio(float bend);
+void midi_set_tuning(const float *tuning);
 float midi_pitch_bend(uint16_t val);
 
 /******************************************************************************
@@ -70,6 +87,25 @@ void block_add(float *out, float *buf);
 void block_add_k(float *out, float k);
 void block_copy(float *dst, const float *src);
 void block_copy_mul_k(float *dst, const float *src, float k);
+void block_mul_add(float *out, const float *a, const float *b);
+void block_mul_add_k(float *out, float k, float c);
+void block_mac(float *out, const float *a, const float *b);
+void block_mac_k(float *out, const float *a, float k);
+void block_mix(float *out, const float *a, float ka, const float *b, float kb);
+void block_copy_mul_ramp(float *dst, const float *src, float k0, float dk);
+void block_to_pcm16(int16_t * dst, const float *l, const float *r, uint32_t * dither);
+
+/* BLOCK_EXPR evaluates an expression of the sample index i for each sample
+ * of a block and stores it in out[i]. A chain of block operations written
+ * as one expression is a single pass over the buffers, e.g.
+ * BLOCK_EXPR(out, i, (out[i] * env[i] * k) + env[i]);
+ */
+#define BLOCK_EXPR(out, i, expr) \
+	do { \
+		for (size_t i = 0; i < AudioBufferSize; i++) { \
+			(out)[i] = (expr); \
+		} \
+	} while (0)
 
 /*****************************************************************************/
 
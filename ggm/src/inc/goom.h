@@ -0,0 +1,47 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Goom Wave Generation
+ */
+
+#ifndef GGM_SRC_INC_GOOM_H
+#define GGM_SRC_INC_GOOM_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * goom wave
+ * The wave shape (duty, slope) and the phase step set the mapping of a phase
+ * onto the cosine LUT. Oscillators keep their own phase accumulator and pass
+ * a block of phases to goom_wave_gen().
+ */
+
+struct goom_wave {
+	float tp;		/* s0f0 to s1f1 transition point */
+	float k0;		/* scaling factor for slope 0 */
+	float k1;		/* scaling factor for slope 1 */
+	float base0;		/* s0f0 mapping: phase offset */
+	float scale0;		/* s0f0 mapping: phase to LUT phase scale */
+	float base1;		/* s1f1 mapping: phase offset */
+	float scale1;		/* s1f1 mapping: phase to LUT phase scale */
+	uint32_t xstep;		/* phase step per sample */
+	uint32_t xreset;	/* phase value for zero output */
+	uint32_t c0;		/* s0 center */
+	uint32_t c1;		/* s1 center */
+	bool step0;		/* generate s0 as a band-limited step */
+	bool step1;		/* generate s1 as a band-limited step */
+};
+
+void goom_wave_shape(struct goom_wave *w, float duty, float slope);
+void goom_wave_step(struct goom_wave *w, uint32_t xstep);
+void goom_wave_gen(const struct goom_wave *w, const uint32_t * x, float *out);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_GOOM_H */
+
+/*****************************************************************************/
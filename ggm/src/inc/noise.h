@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Block Noise Generation
+ */
+
+#ifndef GGM_SRC_INC_NOISE_H
+#define GGM_SRC_INC_NOISE_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * noise generator
+ * NOISE_LANES independent xorshift128 generators produce consecutive samples,
+ * so a block is filled NOISE_LANES samples at a time. Block lengths must be
+ * a multiple of NOISE_LANES.
+ */
+
+#define NOISE_LANES 4
+
+struct noise_gen {
+	uint32_t x[NOISE_LANES];	/* xorshift128 state per lane */
+	uint32_t y[NOISE_LANES];
+	uint32_t z[NOISE_LANES];
+	uint32_t w[NOISE_LANES];
+	float b[2 * NOISE_LANES];	/* pink filter sections */
+	float b6;		/* pink filter delayed term */
+	float brown;		/* brown filter state */
+};
+
+void noise_gen_init(struct noise_gen *g, uint32_t seed);
+void noise_gen_white(struct noise_gen *g, float *out, size_t n);
+void noise_gen_brown(struct noise_gen *g, float *out, size_t n);
+void noise_gen_pink1(struct noise_gen *g, float *out, size_t n);
+void noise_gen_pink2(struct noise_gen *g, float *out, size_t n);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_NOISE_H */
+
+/*****************************************************************************/
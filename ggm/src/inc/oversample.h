@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * 2x/4x Oversampling
+ */
+
+#ifndef GGM_SRC_INC_OVERSAMPLE_H
+#define GGM_SRC_INC_OVERSAMPLE_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * halfband filter stage
+ */
+
+#define HB_MAX_PAIRS 16		/* maximum number of symmetric coefficient pairs */
+#define HB_MAX_HIST ((2 * HB_MAX_PAIRS) - 1)	/* maximum history length */
+
+struct halfband {
+	float z0[HB_MAX_HIST];	/* input (upsampler) or even phase (decimator) history */
+	float z1[HB_MAX_PAIRS];	/* odd phase (decimator) history */
+};
+
+/******************************************************************************
+ * oversampler
+ */
+
+#define OVERSAMPLE_MAX 4	/* maximum oversampling factor */
+
+struct oversample {
+	int factor;		/* oversampling factor (2 or 4) */
+	int channels;		/* number of decimated output channels */
+	struct halfband up[2];	/* upsampling stages */
+	float w0[HB_MAX_HIST + (2 * AudioBufferSize)];	/* work buffer */
+	float w1[HB_MAX_PAIRS + (2 * AudioBufferSize)];	/* work buffer */
+	float mid[2 * AudioBufferSize];	/* 2x rate buffer between 4x stages */
+	float buf[OVERSAMPLE_MAX * AudioBufferSize];	/* oversampled buffer */
+	struct halfband down[][2];	/* decimation stages per channel */
+};
+
+struct oversample *oversample_new(int factor, int channels);
+void oversample_del(struct oversample *os);
+float *oversample_up(struct oversample *os, const float *in);
+void oversample_down(struct oversample *os, float *out);
+void oversample_down_ch(struct oversample *os, int ch, const float *in, float *out, size_t n);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_OVERSAMPLE_H */
+
+/*****************************************************************************/
@@ -0,0 +1,32 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Block Phase Generation
+ */
+
+#ifndef GGM_SRC_INC_PHASE_H
+#define GGM_SRC_INC_PHASE_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * phase generator
+ * Oscillator phases are uint32_t values where FullCycle is one cycle, so the
+ * phase wraps naturally. The generators write the phase of each sample in a
+ * block and advance the phase accumulator *x to the phase of the next sample.
+ */
+
+void phase_gen(uint32_t * out, uint32_t * x, uint32_t xstep, size_t n);
+void phase_gen_fm(uint32_t * out, uint32_t * x, uint32_t xstep, const float *fm, float k, size_t n);
+void phase_gen_pm(uint32_t * out, const float *pm, size_t n);
+void phase_gen_mod(uint32_t * out, uint32_t * x, uint32_t xstep, const float *fm, const float *pm, float k, size_t n);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_PHASE_H */
+
+/*****************************************************************************/
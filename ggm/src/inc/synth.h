@@ -32,11 +32,10 @@ struct midi_map {
 	struct midi_map_entry mme[NUM_MIDI_MAP_ENTRIES];	/* map entries for this CC */
 };
 
-/******************************************************************************
- * top-level synth structure
+/* NUM_EVENTS is sized for a polyphonic patch where each voice sends adsr and
+ * lfo level events every buffer (the queue holds NUM_EVENTS - 1 events).
  */
-
-#define NUM_EVENTS 16		/* must be a power of 2 */
+#define NUM_EVENTS 64		/* must be a power of 2 */
 
 struct qevent {
 	struct module *m;	/* source module */
@@ -51,6 +50,28 @@ struct event_queue {
 	size_t wr;
 };
 
+/******************************************************************************
+ * shared noise bus
+ * Independent white noise streams generated once per buffer for all the
+ * modules that subscribe to them.
+ */
+
+#define NOISE_BUS_STREAMS 8	/* stream buffers are allocated in groups of this size */
+#define NOISE_BUS_MAX_STREAMS 32	/* maximum number of streams */
+
+struct noise_bus {
+	struct noise_gen gen;	/* noise generator */
+	float *buf;		/* stream buffers (size * AudioBufferSize) */
+	int size;		/* number of allocated stream buffers */
+	int streams;		/* number of streams to generate (highest subscribed + 1) */
+	uint32_t used;		/* bitmap of subscribed streams */
+	bool valid;		/* the buffers are valid for this buffer period */
+};
+
+/******************************************************************************
+ * top-level synth structure
+ */
+
 struct synth {
 	struct module *root;	/* root patch */
 	struct event_queue eq;	/* input event queue */
@@ -59,6 +80,7 @@ struct synth {
 	void *driver;		/* pointer to audio/midi driver (E.g. jack) */
 	struct midi_map mmap[NUM_MIDI_MAP_SLOTS];	/* MIDI CC map */
 	float *bufs[MAX_AUDIO_PORTS];	/* allocated audio buffers */
+	struct noise_bus noise;	/* shared noise bus */
 };
 
 /******************************************************************************
@@ -76,6 +98,10 @@ int synth_set_cfg(struct synth *s, const struct synth_cfg *cfg);
 void synth_input_cfg(struct synth *s, struct module *m, const struct port_info *pi);
 bool synth_midi_cc(struct synth *s, const struct event *e);
 
+int synth_noise_subscribe(struct synth *s);
+void synth_noise_unsubscribe(struct synth *s, int idx);
+void synth_noise(struct synth *s, int idx, float *out);
+
 /*****************************************************************************/
 
 #endif				/* GGM_SRC_INC_SYNTH_H */
@@ -27,6 +27,20 @@ static inline float r2d(float r) {
 	return r * (180.f / Pi);
 }
 
+/******************************************************************************
+ * fast trigonometry
+ */
+
+/* tan_pade returns tan(x) for x = 0..pi/2 using a (5,4) Pade approximant.
+ * The relative error is < 1e-6 for x < 1.1 and < 3e-4 for x < 0.49 * pi,
+ * so it's good for filter cutoff warping up to 0.49 * fs.
+ */
+static inline float tan_pade(float x) {
+	float x2 = x * x;
+
+	return x * (945.f + x2 * (-105.f + x2)) / (945.f + x2 * (-420.f + (15.f * x2)));
+}
+
 /******************************************************************************
  * clamp floating point values
  */
@@ -0,0 +1,49 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Band-limited Wavetables
+ */
+
+#ifndef GGM_SRC_INC_WAVETABLE_H
+#define GGM_SRC_INC_WAVETABLE_H
+
+#ifndef GGM_SRC_INC_GGM_H
+#warning "please include this file using ggm.h"
+#endif
+
+/******************************************************************************
+ * wavetable shapes
+ */
+
+enum {
+	WAVETABLE_SHAPE_NULL,
+	WAVETABLE_SHAPE_SAW,	/* sawtooth */
+	WAVETABLE_SHAPE_SQUARE,	/* square */
+	WAVETABLE_SHAPE_TRIANGLE,	/* triangle */
+	WAVETABLE_SHAPE_USER,	/* user supplied single cycle waveform */
+	WAVETABLE_SHAPE_MAX	/* must be last */
+};
+
+/******************************************************************************
+ * shared tables
+ * The mip levels for a shape are built on the first wt_get() and shared
+ * read-only until the last wt_put(). Oscillators keep their own phase
+ * accumulator and pass a block of phases to wt_gen().
+ */
+
+#define WT_BITS 10		/* log2 of the user table size */
+#define WT_SIZE (1U << WT_BITS)	/* user table size */
+
+struct wt_table;
+
+struct wt_table *wt_get(int shape, const float *src);
+void wt_put(struct wt_table *t);
+void wt_gen(const struct wt_table *t, const uint32_t * x, uint32_t xstep, float *out);
+
+/*****************************************************************************/
+
+#endif				/* GGM_SRC_INC_WAVETABLE_H */
+
+/*****************************************************************************/
@@ -4,6 +4,10 @@
  * SPDX-License-Identifier: Apache-2.0
  *
  * Audio Sample Delay Line
+ *
+ * The delay time is set by the "time" event, or per sample by the optional
+ * "dt" audio input (secs). Pass a NULL "dt" buffer when it is not used.
+ * Fractional delays are interpolated (linear, cubic or allpass).
  */
 
 #include "ggm.h"
@@ -13,16 +17,46 @@
  */
 
 struct delay {
-	float *buf;		/* delay line buffer */
-	float t;		/* delay line length (secs) */
-	int n;			/* delay line length (samples) */
-	int wr;			/* write index */
+	struct dline dl;	/* delay line */
+	float t;		/* maximum delay (secs) */
+	float delay;		/* delay time (samples) */
+	int interp;		/* interpolation type */
+	struct dline_allpass ap;	/* allpass interpolation state */
 };
 
 /******************************************************************************
  * module port functions
  */
 
+/* delay_port_time sets the delay time (secs) */
+static void delay_port_time(struct module *m, const struct event *e) {
+	struct delay *this = (struct delay *)m->priv;
+	float t = clampf(event_get_float(e), 0.f, this->t);
+
+	float delay = t * (float)AudioSampleFrequency;
+	float di = truncf(delay + 0.5f);
+
+	/* use the integer delay fast path for rounding errors */
+	if (fabsf(delay - di) < 1e-3f) {
+		delay = di;
+	}
+	LOG_DBG("%s:time %f secs", m->name, t);
+	this->delay = delay;
+}
+
+/* delay_port_interp sets the interpolation type for fractional delays */
+static void delay_port_interp(struct module *m, const struct event *e) {
+	struct delay *this = (struct delay *)m->priv;
+	int interp = event_get_int(e);
+
+	if ((interp < 0) || (interp >= DLINE_INTERP_MAX)) {
+		LOG_ERR("bad interpolation type %d", interp);
+		return;
+	}
+	LOG_DBG("%s:interp %d", m->name, interp);
+	this->interp = interp;
+}
+
 /******************************************************************************
  * module functions
  */
@@ -36,7 +70,7 @@ static int delay_alloc(struct module *m, va_list vargs) {
 	}
 	m->priv = (void *)this;
 
-	/* delay line length (samples) */
+	/* maximum delay line length (samples) */
 	int samples = va_arg(vargs, int);
 	if (samples <= 0) {
 		LOG_ERR("delay samples must be > 0");
@@ -44,21 +78,20 @@ static int delay_alloc(struct module *m, va_list vargs) {
 	}
 
 	/* allocate the delay line */
-	this->n = (size_t)samples;
-	this->t = (float)this->n * AudioSamplePeriod;
-	this->buf = (float *)ggm_calloc(this->n, sizeof(float));
-	if (this->buf == NULL) {
-		LOG_ERR("unable to allocate delay line of %d samples", this->n);
+	if (dline_init(&this->dl, (size_t)samples) != 0) {
 		goto error;
 	}
+	this->t = (float)samples * AudioSamplePeriod;
+
+	/* default to the maximum delay */
+	this->delay = (float)samples;
 
-	LOG_DBG("%s %d samples %f secs", m->name, this->n, this->t);
+	LOG_DBG("%s %d samples %f secs", m->name, samples, this->t);
 
 	return 0;
 
  error:
 
-	ggm_free(this->buf);
 	ggm_free(this);
 	return -1;
 }
@@ -66,30 +99,50 @@ static int delay_alloc(struct module *m, va_list vargs) {
 static void delay_free(struct module *m) {
 	struct delay *this = (struct delay *)m->priv;
 
-	ggm_free(this->buf);
+	dline_free(&this->dl);
 	ggm_free(this);
 }
 
 static bool delay_process(struct module *m, float *bufs[]) {
 	struct delay *this = (struct delay *)m->priv;
 	float *in = bufs[0];
-	float *out = bufs[1];
-	int eob = this->n - 1;
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		/* read index */
-		int rd = this->wr - 1;
-		if (rd < 0) {
-			rd = eob;
+	float *dt = bufs[1];
+	float *out = bufs[2];
+	float delay[AudioBufferSize];
+
+	dline_write(&this->dl, in, AudioBufferSize);
+
+	if (dt == NULL) {
+		/* fixed delay */
+		if (this->delay == truncf(this->delay)) {
+			dline_read(&this->dl, out, AudioBufferSize, (size_t)this->delay);
+			return true;
 		}
-		/* write/read */
-		this->buf[this->wr] = in[i];
-		out[i] = this->buf[rd];
-		/* advance the write index */
-		this->wr += 1;
-		if (this->wr > eob) {
-			this->wr = 0;
+		if (this->interp == DLINE_INTERP_ALLPASS) {
+			dline_read_allpass(&this->dl, &this->ap, out, AudioBufferSize, this->delay);
+			return true;
 		}
+		for (int i = 0; i < AudioBufferSize; i++) {
+			delay[i] = this->delay;
+		}
+	} else {
+		/* audio rate delay time (secs) */
+		for (int i = 0; i < AudioBufferSize; i++) {
+			delay[i] = dt[i] * (float)AudioSampleFrequency;
+		}
+	}
+
+	switch (this->interp) {
+	case DLINE_INTERP_CUBIC:
+		dline_read_cubic(&this->dl, out, AudioBufferSize, delay);
+		break;
+	case DLINE_INTERP_ALLPASS:
+		/* allpass interpolation can't track an audio rate delay time */
+		dline_read_allpass(&this->dl, &this->ap, out, AudioBufferSize, delay[0]);
+		break;
+	default:
+		dline_read_linear(&this->dl, out, AudioBufferSize, delay);
+		break;
 	}
 	return true;
 }
@@ -100,6 +153,9 @@ static bool delay_process(struct module *m, float *bufs[]) {
 
 static const struct port_info in_ports[] = {
 	{.name = "in",.type = PORT_TYPE_AUDIO,},
+	{.name = "dt",.type = PORT_TYPE_AUDIO,},
+	{.name = "time",.type = PORT_TYPE_FLOAT,.pf = delay_port_time},
+	{.name = "interp",.type = PORT_TYPE_INT,.pf = delay_port_interp},
 	PORT_EOL,
 };
 
@@ -0,0 +1,289 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Feedback Delay Network Reverb
+ *
+ * 4, 8 or 16 delay lines (module argument) with a Hadamard feedback matrix.
+ * Each line has a feedback gain for the decay time and a one-pole low pass
+ * filter for high frequency damping.
+ *
+ * The shortest delay line is longer than a buffer, so the network is
+ * processed a block at a time: read a block from each line, filter it,
+ * mix the lines with a fast Walsh-Hadamard transform and write the block
+ * back. The inner loops run across the samples of a block, so they map
+ * onto SIMD lanes.
+ *
+ * Use fewer lines on targets with less memory/cpu. 4 lines use a shorter
+ * set of delay lines that each fit a 1024 sample ring buffer, so the
+ * module needs about 19KB of heap (it fits the 32KB heap on STM32F4).
+ * 8 and 16 lines need about 100KB and 200KB.
+ */
+
+#include "ggm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ * private state
+ */
+
+#define FDN_MAX_LINES 16
+
+/* mutually prime delay line lengths (samples), ~21..81 ms */
+static const int fdn_length[FDN_MAX_LINES] = {
+	1009, 1097, 1201, 1319, 1439, 1579, 1723, 1889,
+	2069, 2267, 2477, 2713, 2971, 3253, 3571, 3907,
+};
+
+/* 4 line lengths (samples), ~10..18 ms, each <= 1024 - AudioBufferSize - 4 */
+static const int fdn_length4[4] = {
+	461, 587, 719, 881,
+};
+
+struct fdn_line {
+	struct dline dl;	/* delay line */
+	int n;			/* delay line length (samples) */
+	float g;		/* feedback gain */
+	float z;		/* damping filter state */
+};
+
+struct fdn {
+	int lines;		/* number of delay lines */
+	float time;		/* decay time (secs) */
+	float damp;		/* damping filter coefficient */
+	float norm;		/* hadamard normalisation 1/sqrt(lines) */
+	float *buf;		/* line buffers (lines * AudioBufferSize) */
+	struct fdn_line line[FDN_MAX_LINES];
+};
+
+#define LOG2_10 (3.321928094887362f)	/* math.log2(10.0) */
+
+/******************************************************************************
+ * fdn functions
+ */
+
+/* fdn_set_gain sets the feedback gains for the decay time (-60 dB) */
+static void fdn_set_gain(struct fdn *this) {
+	float k = -3.f * LOG2_10 / (this->time * (float)AudioSampleFrequency);
+
+	for (int i = 0; i < this->lines; i++) {
+		struct fdn_line *l = &this->line[i];
+		/* 10^(-3 * n / (time * fs)), with the hadamard normalisation */
+		l->g = pow2(k * (float)l->n) * this->norm;
+	}
+}
+
+/* fdn_butterfly does (a, b) = (a + b, a - b) for n (a multiple of 4) samples */
+static void fdn_butterfly(float *a, float *b, size_t n) {
+#if defined(__SSE2__)
+	for (size_t i = 0; i < n; i += 4) {
+		__m128 x = _mm_loadu_ps(&a[i]);
+		__m128 y = _mm_loadu_ps(&b[i]);
+		_mm_storeu_ps(&a[i], _mm_add_ps(x, y));
+		_mm_storeu_ps(&b[i], _mm_sub_ps(x, y));
+	}
+#elif defined(__ARM_NEON)
+	for (size_t i = 0; i < n; i += 4) {
+		float32x4_t x = vld1q_f32(&a[i]);
+		float32x4_t y = vld1q_f32(&b[i]);
+		vst1q_f32(&a[i], vaddq_f32(x, y));
+		vst1q_f32(&b[i], vsubq_f32(x, y));
+	}
+#else
+	for (size_t i = 0; i < n; i++) {
+		float x = a[i];
+		a[i] = x + b[i];
+		b[i] = x - b[i];
+	}
+#endif
+}
+
+/* fdn_hadamard mixes the line buffers with a fast Walsh-Hadamard transform */
+static void fdn_hadamard(struct fdn *this) {
+	int lines = this->lines;
+
+	for (int h = 1; h < lines; h <<= 1) {
+		for (int j = 0; j < lines; j += h << 1) {
+			for (int k = j; k < j + h; k++) {
+				fdn_butterfly(&this->buf[k * AudioBufferSize], &this->buf[(k + h) * AudioBufferSize], AudioBufferSize);
+			}
+		}
+	}
+}
+
+/* fdn_damp applies the feedback gain and damping filter to a line buffer */
+static void fdn_damp(struct fdn_line *l, float *x, float damp) {
+	float z = l->z;
+	float g = l->g;
+
+	for (int i = 0; i < AudioBufferSize; i++) {
+		z = x[i] + (damp * (z - x[i]));
+		x[i] = g * z;
+	}
+	l->z = z;
+}
+
+/******************************************************************************
+ * module port functions
+ */
+
+/* fdn_port_time sets the decay time (secs) */
+static void fdn_port_time(struct module *m, const struct event *e) {
+	struct fdn *this = (struct fdn *)m->priv;
+	float time = clampf(event_get_float(e), 0.1f, 30.f);
+
+	LOG_INF("set decay time %f secs", time);
+	this->time = time;
+	fdn_set_gain(this);
+}
+
+/* fdn_port_damping sets the high frequency damping 0..1 */
+static void fdn_port_damping(struct module *m, const struct event *e) {
+	struct fdn *this = (struct fdn *)m->priv;
+	float damping = clampf(event_get_float(e), 0.f, 1.f);
+
+	LOG_INF("set damping %f", damping);
+	this->damp = 0.95f * damping;
+}
+
+/******************************************************************************
+ * module functions
+ */
+
+static int fdn_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct fdn *this = ggm_calloc(1, sizeof(struct fdn));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	/* number of delay lines */
+	int lines = va_arg(vargs, int);
+	if ((lines != 4) && (lines != 8) && (lines != 16)) {
+		LOG_ERR("bad number of delay lines %d", lines);
+		goto error;
+	}
+	this->lines = lines;
+
+	/* allocate the line buffers */
+	this->buf = ggm_calloc(lines * AudioBufferSize, sizeof(float));
+	if (this->buf == NULL) {
+		goto error;
+	}
+
+	/* allocate the delay lines, spread across the length table */
+	for (int i = 0; i < lines; i++) {
+		struct fdn_line *l = &this->line[i];
+		l->n = (lines == 4) ? fdn_length4[i] : fdn_length[i * (FDN_MAX_LINES / lines)];
+		if (dline_init(&l->dl, l->n) != 0) {
+			goto error;
+		}
+	}
+
+	/* 1/sqrt(lines) */
+	this->norm = 1.f;
+	for (int h = 1; h < lines; h <<= 1) {
+		this->norm *= 0.70710678f;
+	}
+
+	/* defaults */
+	this->time = 2.f;
+	this->damp = 0.5f;
+	fdn_set_gain(this);
+
+	return 0;
+
+ error:
+	for (int i = 0; i < FDN_MAX_LINES; i++) {
+		dline_free(&this->line[i].dl);
+	}
+	ggm_free(this->buf);
+	ggm_free(this);
+	return -1;
+}
+
+static void fdn_free(struct module *m) {
+	struct fdn *this = (struct fdn *)m->priv;
+
+	for (int i = 0; i < this->lines; i++) {
+		dline_free(&this->line[i].dl);
+	}
+	ggm_free(this->buf);
+	ggm_free(this);
+}
+
+static bool fdn_process(struct module *m, float *bufs[]) {
+	struct fdn *this = (struct fdn *)m->priv;
+	float *in = bufs[0];
+	float *out0 = bufs[1];
+	float *out1 = bufs[2];
+	int lines = this->lines;
+
+	/* Read a block from each line. The block hasn't been written yet, so
+	 * the delay is relative to the previous block.
+	 */
+	for (int i = 0; i < lines; i++) {
+		struct fdn_line *l = &this->line[i];
+		dline_read(&l->dl, &this->buf[i * AudioBufferSize], AudioBufferSize, l->n - AudioBufferSize);
+	}
+
+	/* even lines to the left output, odd lines to the right output */
+	block_copy_mul_k(out0, &this->buf[0], this->norm);
+	block_copy_mul_k(out1, &this->buf[AudioBufferSize], this->norm);
+	for (int i = 2; i < lines; i += 2) {
+		block_mac_k(out0, &this->buf[i * AudioBufferSize], this->norm);
+		block_mac_k(out1, &this->buf[(i + 1) * AudioBufferSize], this->norm);
+	}
+
+	/* damping, feedback matrix and input */
+	for (int i = 0; i < lines; i++) {
+		fdn_damp(&this->line[i], &this->buf[i * AudioBufferSize], this->damp);
+	}
+	fdn_hadamard(this);
+	for (int i = 0; i < lines; i++) {
+		float *x = &this->buf[i * AudioBufferSize];
+		block_add(x, in);
+		dline_write(&this->line[i].dl, x, AudioBufferSize);
+	}
+
+	return true;
+}
+
+/******************************************************************************
+ * module information
+ */
+
+static const struct port_info in_ports[] = {
+	{.name = "in",.type = PORT_TYPE_AUDIO,},
+	{.name = "time",.type = PORT_TYPE_FLOAT,.pf = fdn_port_time},
+	{.name = "damping",.type = PORT_TYPE_FLOAT,.pf = fdn_port_damping},
+	PORT_EOL,
+};
+
+static const struct port_info out_ports[] = {
+	{.name = "out0",.type = PORT_TYPE_AUDIO,},
+	{.name = "out1",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+const struct module_info delay_fdn_module = {
+	.mname = "delay/fdn",
+	.iname = "fdn",
+	.in = in_ports,
+	.out = out_ports,
+	.alloc = fdn_alloc,
+	.free = fdn_free,
+	.process = fdn_process,
+};
+
+MODULE_REGISTER(delay_fdn_module);
+
+/*****************************************************************************/
@@ -4,6 +4,14 @@
  * SPDX-License-Identifier: Apache-2.0
  *
  * Attack/Decay/Sustain/Release Envelope Generator
+ *
+ * In control rate mode ("control" = true) the envelope is stepped once per
+ * ADSR_CONTROL_BLOCK samples and the audio output is a linear ramp between
+ * the control values. The "level" output sends the envelope value once per
+ * buffer (when it changes) for modulating event driven parameters.
+ *
+ * With "fixed" set the audio rate envelope is rendered in q31 (for targets
+ * without float SIMD). Control rate mode is always float.
  */
 
 #include "ggm.h"
@@ -21,17 +29,33 @@ enum adsr_state {
 	ADSR_STATE_RESET,
 };
 
-struct adsr {
-	enum adsr_state state;	/* envelope state */
-	float s;		/* sustain level */
+/* envelope samples per control rate step */
+#define ADSR_CONTROL_BLOCK 16
+#define ADSR_CONTROL_RATE (AudioSampleFrequency / ADSR_CONTROL_BLOCK)
+
+/* output port index of the level output */
+#define ADSR_PORT_LEVEL 1
+
+/* rate dependent constants */
+struct adsr_k {
 	float ka;		/* attack constant */
 	float kd;		/* decay constant */
 	float kr;		/* release constant */
 	float k_reset;		/* soft reset constant */
+};
+
+struct adsr {
+	enum adsr_state state;	/* envelope state */
+	float s;		/* sustain level */
+	struct adsr_k k;	/* audio rate constants */
+	struct adsr_k kc;	/* control rate constants */
 	float d_trigger;	/* attack->decay trigger level */
 	float s_trigger;	/* decay->sustain trigger level */
 	float i_trigger;	/* release->idle trigger level */
 	float val;		/* output value */
+	float level;		/* last value sent on the level output */
+	bool control;		/* control rate mode */
+	bool fixed;		/* q31 processing */
 };
 
 /* When we need to shutdown a voice we do it slowly to avoid any clicks in
@@ -138,7 +162,7 @@ static void adsr_port_gate(struct module *m, const struct event *e) {
 
 	/* release */
 	if (this->state != ADSR_STATE_IDLE) {
-		if (this->kr == 1.f) {
+		if (this->k.kr == 1.f) {
 			/* no release - goto idle */
 			this->val = 0.f;
 			this->state = ADSR_STATE_IDLE;
@@ -154,7 +178,8 @@ static void adsr_port_attack(struct module *m, const struct event *e) {
 	float attack = clampf_lo(event_get_float(e), MIN_ATTACK_TIME);
 
 	LOG_DBG("%s:attack %f secs", m->name, attack);
-	this->ka = get_k(attack, AudioSampleFrequency);
+	this->k.ka = get_k(attack, AudioSampleFrequency);
+	this->kc.ka = get_k(attack, ADSR_CONTROL_RATE);
 }
 
 /* adsr_port_decay sets the decay time (secs) */
@@ -163,7 +188,8 @@ static void adsr_port_decay(struct module *m, const struct event *e) {
 	float decay = clampf_lo(event_get_float(e), MIN_DECAY_TIME);
 
 	LOG_DBG("%s:decay %f secs", m->name, decay);
-	this->kd = get_k(decay, AudioSampleFrequency);
+	this->k.kd = get_k(decay, AudioSampleFrequency);
+	this->kc.kd = get_k(decay, ADSR_CONTROL_RATE);
 }
 
 /* adsr_port_sustain sets the sustain level 0..1 */
@@ -184,7 +210,24 @@ static void adsr_port_release(struct module *m, const struct event *e) {
 	float release = clampf_lo(event_get_float(e), MIN_RELEASE_TIME);
 
 	LOG_DBG("%s:release %f secs", m->name, release);
-	this->kr = get_k(release, AudioSampleFrequency);
+	this->k.kr = get_k(release, AudioSampleFrequency);
+	this->kc.kr = get_k(release, ADSR_CONTROL_RATE);
+}
+
+/* adsr_port_control selects control rate (true) or audio rate (false) mode */
+static void adsr_port_control(struct module *m, const struct event *e) {
+	struct adsr *this = (struct adsr *)m->priv;
+
+	this->control = event_get_bool(e);
+	LOG_DBG("%s:control %d", m->name, this->control);
+}
+
+/* adsr_port_fixed selects q31 (true) or float (false) processing */
+static void adsr_port_fixed(struct module *m, const struct event *e) {
+	struct adsr *this = (struct adsr *)m->priv;
+
+	this->fixed = event_get_bool(e);
+	LOG_DBG("%s:fixed %d", m->name, this->fixed);
 }
 
 /******************************************************************************
@@ -201,7 +244,8 @@ static int adsr_alloc(struct module *m, va_list vargs) {
 	m->priv = (void *)this;
 
 	/* set the soft reset time */
-	this->k_reset = get_k(SOFT_RESET_TIME, AudioSampleFrequency);
+	this->k.k_reset = get_k(SOFT_RESET_TIME, AudioSampleFrequency);
+	this->kc.k_reset = get_k(SOFT_RESET_TIME, ADSR_CONTROL_RATE);
 
 	return 0;
 }
@@ -210,83 +254,262 @@ static void adsr_free(struct module *m) {
 	ggm_free(m->priv);
 }
 
-static bool adsr_process(struct module *m, float *buf[]) {
-	struct adsr *this = (struct adsr *)m->priv;
-	float *out = buf[0];
+/******************************************************************************
+ * envelope segments
+ * Each stage is rendered as a run of samples with a tight loop on local
+ * variables. The run ends at the end of the buffer or when the trigger level
+ * is crossed. The sample that crosses the trigger does the stage transition,
+ * so the output is the same as stepping the state machine per sample.
+ */
 
-	if (this->state == ADSR_STATE_IDLE) {
-		/* no output */
-		return false;
+/* adsr_rise runs val += k * (target - val) while val < trigger.
+ * It returns the number of samples written to out (<= n).
+ */
+static int adsr_rise(float *out, int n, float *val, float target, float k, float trigger) {
+	float x = *val;
+	int i = 0;
+
+	while ((i < n) && (x < trigger)) {
+		x += k * (target - x);
+		out[i++] = x;
 	}
+	*val = x;
+	return i;
+}
 
-	for (int i = 0; i < AudioBufferSize; i++) {
-		switch (this->state) {
+/* adsr_fall runs val += k * (target - val) while val > trigger.
+ * It returns the number of samples written to out (<= n).
+ */
+static int adsr_fall(float *out, int n, float *val, float target, float k, float trigger) {
+	float x = *val;
+	int i = 0;
 
-		case ADSR_STATE_IDLE:
-			/* idle - do nothing */
-			break;
+	while ((i < n) && (x > trigger)) {
+		x += k * (target - x);
+		out[i++] = x;
+	}
+	*val = x;
+	return i;
+}
+
+/* adsr_fill writes a constant value to out */
+static void adsr_fill(float *out, int n, float val) {
+	for (int i = 0; i < n; i++) {
+		out[i] = val;
+	}
+}
+
+/* adsr_render steps the envelope n times using the k constants */
+static void adsr_render(struct adsr *this, float *out, int n, const struct adsr_k *k) {
+	enum adsr_state state = this->state;
+	float val = this->val;
+	int i = 0;
+
+	while (i < n) {
+		switch (state) {
 
 		case ADSR_STATE_ATTACK:
 			/* attack until 1.0 level */
-			if (this->val < this->d_trigger) {
-				this->val += this->ka * (1.f - this->val);
-			} else {
+			i += adsr_rise(&out[i], n - i, &val, 1.f, k->ka, this->d_trigger);
+			if (i < n) {
 				/* goto decay state */
-				this->val = 1.f;
-				this->state = ADSR_STATE_DECAY;
+				val = 1.f;
+				state = ADSR_STATE_DECAY;
+				out[i++] = val;
 			}
 			break;
 
 		case ADSR_STATE_DECAY:
 			/* decay until sustain level */
-			if (this->val > this->s_trigger) {
-				this->val += this->kd * (this->s - this->val);
-			} else {
+			i += adsr_fall(&out[i], n - i, &val, this->s, k->kd, this->s_trigger);
+			if (i < n) {
 				if (this->s != 0.f) {
 					/* goto sustain state */
-					this->val = this->s;
-					this->state = ADSR_STATE_SUSTAIN;
+					val = this->s;
+					state = ADSR_STATE_SUSTAIN;
 				} else {
 					/* no sustain, goto idle state */
-					this->val = 0.f;
-					this->state = ADSR_STATE_IDLE;
+					val = 0.f;
+					state = ADSR_STATE_IDLE;
 				}
+				out[i++] = val;
 			}
 			break;
 
+		case ADSR_STATE_RELEASE:
+		case ADSR_STATE_RESET:
+			/* release (or soft reset) until idle level */
+			i += adsr_fall(&out[i], n - i, &val, 0.f, (state == ADSR_STATE_RELEASE) ? k->kr : k->k_reset, this->i_trigger);
+			if (i < n) {
+				/* goto idle state */
+				val = 0.f;
+				state = ADSR_STATE_IDLE;
+				out[i++] = val;
+			}
+			break;
+
+		case ADSR_STATE_IDLE:
 		case ADSR_STATE_SUSTAIN:
-			/* sustain - do nothing */
+			/* constant output for the rest of the buffer */
+			adsr_fill(&out[i], n - i, val);
+			i = n;
 			break;
 
-		case ADSR_STATE_RELEASE:
-			/* release until idle level */
-			if (this->val > this->i_trigger) {
-				this->val += this->kr * (0.f - this->val);
-			} else {
-				/* goto idle state */
-				this->val = 0.f;
-				this->state = ADSR_STATE_IDLE;
+		default:
+			LOG_ERR("bad adsr state %d", state);
+			val = 0.f;
+			state = ADSR_STATE_IDLE;
+			break;
+		}
+	}
+
+	this->state = state;
+	this->val = val;
+}
+
+/******************************************************************************
+ * q31 envelope segments
+ * The same segments as above with q31 values. The state between blocks is
+ * kept as a float, so the mode can be changed at any time.
+ */
+
+/* adsr_rise_q31 runs val += k * (target - val) while val < trigger */
+static int adsr_rise_q31(q31_t * out, int n, q31_t * val, q31_t target, q31_t k, q31_t trigger) {
+	q31_t x = *val;
+	int i = 0;
+
+	while ((i < n) && (x < trigger)) {
+		x = q31_add(x, q31_mul(k, target - x));
+		out[i++] = x;
+	}
+	*val = x;
+	return i;
+}
+
+/* adsr_fall_q31 runs val += k * (target - val) while val > trigger */
+static int adsr_fall_q31(q31_t * out, int n, q31_t * val, q31_t target, q31_t k, q31_t trigger) {
+	q31_t x = *val;
+	int i = 0;
+
+	while ((i < n) && (x > trigger)) {
+		x = q31_add(x, q31_mul(k, target - x));
+		out[i++] = x;
+	}
+	*val = x;
+	return i;
+}
+
+/* adsr_fill_q31 writes a constant value to out */
+static void adsr_fill_q31(q31_t * out, int n, q31_t val) {
+	for (int i = 0; i < n; i++) {
+		out[i] = val;
+	}
+}
+
+/* adsr_render_q31 steps the envelope n times using the audio rate constants */
+static void adsr_render_q31(struct adsr *this, q31_t * out, int n) {
+	enum adsr_state state = this->state;
+	q31_t val = float_to_q31(this->val);
+	q31_t s = float_to_q31(this->s);
+	q31_t ka = float_to_q31(this->k.ka);
+	q31_t kd = float_to_q31(this->k.kd);
+	q31_t kr = float_to_q31(this->k.kr);
+	q31_t k_reset = float_to_q31(this->k.k_reset);
+	int i = 0;
+
+	while (i < n) {
+		switch (state) {
+
+		case ADSR_STATE_ATTACK:
+			i += adsr_rise_q31(&out[i], n - i, &val, Q31_MAX, ka, float_to_q31(this->d_trigger));
+			if (i < n) {
+				val = Q31_MAX;
+				state = ADSR_STATE_DECAY;
+				out[i++] = val;
 			}
 			break;
 
+		case ADSR_STATE_DECAY:
+			i += adsr_fall_q31(&out[i], n - i, &val, s, kd, float_to_q31(this->s_trigger));
+			if (i < n) {
+				val = s;
+				state = (s != 0) ? ADSR_STATE_SUSTAIN : ADSR_STATE_IDLE;
+				out[i++] = val;
+			}
+			break;
+
+		case ADSR_STATE_RELEASE:
 		case ADSR_STATE_RESET:
-			/* soft reset to the idle level */
-			if (this->val > this->i_trigger) {
-				this->val += this->k_reset * (0.f - this->val);
-			} else {
-				/* goto idle state */
-				this->val = 0.f;
-				this->state = ADSR_STATE_IDLE;
+			i += adsr_fall_q31(&out[i], n - i, &val, 0, (state == ADSR_STATE_RELEASE) ? kr : k_reset, float_to_q31(this->i_trigger));
+			if (i < n) {
+				val = 0;
+				state = ADSR_STATE_IDLE;
+				out[i++] = val;
 			}
 			break;
 
+		case ADSR_STATE_IDLE:
+		case ADSR_STATE_SUSTAIN:
+			adsr_fill_q31(&out[i], n - i, val);
+			i = n;
+			break;
+
 		default:
-			LOG_ERR("bad adsr state %d", this->state);
-			this->val = 0.f;
-			this->state = ADSR_STATE_IDLE;
+			LOG_ERR("bad adsr state %d", state);
+			val = 0;
+			state = ADSR_STATE_IDLE;
 			break;
 		}
-		out[i] = this->val;
+	}
+
+	this->state = state;
+	this->val = q31_to_float(val);
+}
+
+/* adsr_render_control steps the envelope at the control rate and
+ * interpolates the audio output.
+ */
+static void adsr_render_control(struct adsr *this, float *out) {
+	float ctl[AudioBufferSize / ADSR_CONTROL_BLOCK];
+	float x0 = this->val;
+
+	adsr_render(this, ctl, AudioBufferSize / ADSR_CONTROL_BLOCK, &this->kc);
+
+	for (int j = 0; j < AudioBufferSize / ADSR_CONTROL_BLOCK; j++) {
+		float dx = (ctl[j] - x0) * (1.f / (float)ADSR_CONTROL_BLOCK);
+		float *y = &out[j * ADSR_CONTROL_BLOCK];
+		for (int i = 0; i < ADSR_CONTROL_BLOCK; i++) {
+			y[i] = x0 + ((float)(i + 1) * dx);
+		}
+		x0 = ctl[j];
+	}
+}
+
+static bool adsr_process(struct module *m, float *buf[]) {
+	struct adsr *this = (struct adsr *)m->priv;
+	float *out = buf[0];
+
+	if (this->state == ADSR_STATE_IDLE) {
+		/* no output */
+		return false;
+	}
+
+	if (this->control) {
+		adsr_render_control(this, out);
+	} else if (this->fixed) {
+		q31_t y[AudioBufferSize];
+		adsr_render_q31(this, y, AudioBufferSize);
+		block_q31_to_float(out, y);
+	} else {
+		adsr_render(this, out, AudioBufferSize, &this->k);
+	}
+
+	/* send the level once per buffer (if it's connected) */
+	if ((this->val != this->level) && (m->dst[ADSR_PORT_LEVEL] != NULL)) {
+		struct event e;
+		event_set_float(&e, this->val);
+		event_push(m, ADSR_PORT_LEVEL, &e);
+		this->level = this->val;
 	}
 
 	return true;
@@ -303,11 +526,14 @@ static const struct port_info in_ports[] = {
 	{.name = "decay",.type = PORT_TYPE_FLOAT,.pf = adsr_port_decay,.mf = adsr_midi_decay,},
 	{.name = "sustain",.type = PORT_TYPE_FLOAT,.pf = adsr_port_sustain,.mf = adsr_midi_sustain,},
 	{.name = "release",.type = PORT_TYPE_FLOAT,.pf = adsr_port_release,.mf = adsr_midi_release,},
+	{.name = "control",.type = PORT_TYPE_BOOL,.pf = adsr_port_control},
+	{.name = "fixed",.type = PORT_TYPE_BOOL,.pf = adsr_port_fixed},
 	PORT_EOL,
 };
 
 static const struct port_info out_ports[] = {
 	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	{.name = "level",.type = PORT_TYPE_FLOAT,},
 	PORT_EOL,
 };
 
@@ -5,39 +5,100 @@
  *
  * BiQuad Filter
  * See: http://www.earlevel.com/main/2003/02/28/biquads/
+ *
+ * RBJ low pass, high pass, band pass, notch, peaking and shelving filters
+ * in transposed direct form 2. With GGM_CMSIS_DSP the filter is run by
+ * arm_biquad_cascade_df2T_f32().
+ *
+ * Arguments:
+ * int, filter type (BIQUAD_TYPE_*)
  */
 
 #include "ggm.h"
 #include "filter/filter.h"
 
+#if defined(GGM_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
 /******************************************************************************
  * private state
  */
 
+#define BIQUAD_Q_MIN (0.7071f)	/* butterworth */
+#define BIQUAD_Q_MAX (20.f)
+
 struct biquad {
+	int type;		/* filter type */
+	float cutoff;		/* cutoff/center frequency (Hz) */
+	float q;		/* filter Q */
+	float gain;		/* peak/shelf gain (dB) */
 	float a0, a1, a2;	/* zero coefficients */
 	float b1, b2;		/* pole coefficients */
 	float d1, d2;		/* delay variables */
+#if defined(GGM_CMSIS_DSP)
+	arm_biquad_cascade_df2T_instance_f32 cmsis;	/* CMSIS-DSP filter instance */
+	float coeffs[5];	/* CMSIS-DSP coefficients */
+	float state[2];		/* CMSIS-DSP state variables */
+#endif
 };
 
+/******************************************************************************
+ * biquad functions
+ */
+
+/* biquad_update_coeffs is called when the filter parameters have changed */
+static void biquad_update_coeffs(struct module *m) {
+	struct biquad *this = (struct biquad *)m->priv;
+	struct biquad_coeffs c;
+
+	biquad_design(&c, this->type, this->cutoff, this->q, this->gain);
+	this->a0 = c.a0;
+	this->a1 = c.a1;
+	this->a2 = c.a2;
+	this->b1 = c.b1;
+	this->b2 = c.b2;
+
+#if defined(GGM_CMSIS_DSP)
+	/* CMSIS-DSP uses {b0, b1, b2, a1, a2} with the feedback terms added */
+	this->coeffs[0] = this->a0;
+	this->coeffs[1] = this->a1;
+	this->coeffs[2] = this->a2;
+	this->coeffs[3] = -this->b1;
+	this->coeffs[4] = -this->b2;
+#endif
+}
+
 /******************************************************************************
  * module port functions
  */
 
 static void biquad_port_cutoff(struct module *m, const struct event *e) {
-	// struct biquad *this = (struct biquad *)m->priv;
+	struct biquad *this = (struct biquad *)m->priv;
 	float cutoff = clampf(event_get_float(e), 0.f, 0.5f * AudioSampleFrequency);
 
 	LOG_INF("set cutoff frequency %f Hz", cutoff);
-	/* TODO */
+	this->cutoff = cutoff;
+	biquad_update_coeffs(m);
 }
 
 static void biquad_port_resonance(struct module *m, const struct event *e) {
-	// struct biquad *this = (struct biquad *)m->priv;
+	struct biquad *this = (struct biquad *)m->priv;
 	float resonance = clampf(event_get_float(e), 0.f, 1.f);
 
 	LOG_INF("set resonance %f", resonance);
-	/* TODO */
+	/* Q = 0.707 (butterworth) .. 20 */
+	this->q = map_exp(resonance, BIQUAD_Q_MIN, BIQUAD_Q_MAX, 4.f);
+	biquad_update_coeffs(m);
+}
+
+static void biquad_port_gain(struct module *m, const struct event *e) {
+	struct biquad *this = (struct biquad *)m->priv;
+	float gain = clampf(event_get_float(e), -24.f, 24.f);
+
+	LOG_INF("set gain %f dB", gain);
+	this->gain = gain;
+	biquad_update_coeffs(m);
 }
 
 /******************************************************************************
@@ -53,7 +114,28 @@ static int biquad_alloc(struct module *m, va_list vargs) {
 	}
 	m->priv = (void *)this;
 
+	/* set the filter type */
+	this->type = va_arg(vargs, int);
+	if ((this->type <= 0) || (this->type >= BIQUAD_TYPE_MAX)) {
+		LOG_ERR("bad filter type %d", this->type);
+		goto error;
+	}
+
+	/* default parameters */
+	this->cutoff = 1000.f;
+	this->q = BIQUAD_Q_MIN;
+	this->gain = 0.f;
+
+#if defined(GGM_CMSIS_DSP)
+	arm_biquad_cascade_df2T_init_f32(&this->cmsis, 1, this->coeffs, this->state);
+#endif
+	biquad_update_coeffs(m);
+
 	return 0;
+
+ error:
+	ggm_free(this);
+	return -1;
 }
 
 static void biquad_free(struct module *m) {
@@ -62,6 +144,17 @@ static void biquad_free(struct module *m) {
 	ggm_free(this);
 }
 
+#if defined(GGM_CMSIS_DSP)
+
+static bool biquad_process(struct module *m, float *bufs[]) {
+	struct biquad *this = (struct biquad *)m->priv;
+
+	arm_biquad_cascade_df2T_f32(&this->cmsis, bufs[0], bufs[1], AudioBufferSize);
+	return true;
+}
+
+#else
+
 static bool biquad_process(struct module *m, float *bufs[]) {
 	struct biquad *this = (struct biquad *)m->priv;
 	float *in = bufs[0];
@@ -75,11 +168,12 @@ static bool biquad_process(struct module *m, float *bufs[]) {
 	float d2 = this->d2;
 
 	for (int i = 0; i < AudioBufferSize; i++) {
-		/* direct form 2 */
-		float d0 = in[i] - (b1 * d1) - (b2 * d2);
-		out[i] = (a0 * d0) + (a1 * d1) + (a2 * d2);
-		d1 = d0;
-		d2 = d1;
+		/* transposed direct form 2 */
+		float x = in[i];
+		float y = (a0 * x) + d1;
+		d1 = (a1 * x) - (b1 * y) + d2;
+		d2 = (a2 * x) - (b2 * y);
+		out[i] = y;
 	}
 
 	/* store the delay variables */
@@ -89,6 +183,8 @@ static bool biquad_process(struct module *m, float *bufs[]) {
 	return true;
 }
 
+#endif
+
 /******************************************************************************
  * module information
  */
@@ -97,6 +193,7 @@ static const struct port_info in_ports[] = {
 	{.name = "in",.type = PORT_TYPE_AUDIO,},
 	{.name = "cutoff",.type = PORT_TYPE_FLOAT,.pf = biquad_port_cutoff},
 	{.name = "resonance",.type = PORT_TYPE_FLOAT,.pf = biquad_port_resonance},
+	{.name = "gain",.type = PORT_TYPE_FLOAT,.pf = biquad_port_gain},
 	PORT_EOL,
 };
 
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * 4-Band Equaliser
+ *
+ * A low shelf, two peaking and a high shelf filter. The bands are run as a
+ * pipelined cascade in a single biquad bank (see core/biquad.c), which is
+ * much cheaper than chaining four filter/biquad modules.
+ */
+
+#include "ggm.h"
+
+/******************************************************************************
+ * private state
+ */
+
+#define EQ_BANDS BIQUAD_LANES
+
+struct eq_band {
+	int type;		/* filter type */
+	float freq;		/* frequency (Hz) */
+	float q;		/* filter Q */
+	float gain;		/* gain (dB) */
+};
+
+struct eq {
+	struct eq_band band[EQ_BANDS];	/* band parameters */
+	struct biquad_bank bank;	/* filter bank */
+};
+
+static const struct eq_band eq_default[EQ_BANDS] = {
+	{BIQUAD_TYPE_LOWSHELF, 100.f, 0.7071f, 0.f},
+	{BIQUAD_TYPE_PEAK, 500.f, 1.f, 0.f},
+	{BIQUAD_TYPE_PEAK, 2000.f, 1.f, 0.f},
+	{BIQUAD_TYPE_HIGHSHELF, 8000.f, 0.7071f, 0.f},
+};
+
+/******************************************************************************
+ * eq functions
+ */
+
+static void eq_update(struct module *m, int idx) {
+	struct eq *this = (struct eq *)m->priv;
+	struct eq_band *b = &this->band[idx];
+	struct biquad_coeffs c;
+
+	biquad_design(&c, b->type, b->freq, b->q, b->gain);
+	biquad_bank_set(&this->bank, idx, &c);
+}
+
+static void eq_set_freq(struct module *m, int idx, const struct event *e) {
+	struct eq *this = (struct eq *)m->priv;
+	float freq = clampf(event_get_float(e), 20.f, 20000.f);
+
+	LOG_INF("set band %d frequency %f Hz", idx, freq);
+	this->band[idx].freq = freq;
+	eq_update(m, idx);
+}
+
+static void eq_set_gain(struct module *m, int idx, const struct event *e) {
+	struct eq *this = (struct eq *)m->priv;
+	float gain = clampf(event_get_float(e), -24.f, 24.f);
+
+	LOG_INF("set band %d gain %f dB", idx, gain);
+	this->band[idx].gain = gain;
+	eq_update(m, idx);
+}
+
+/******************************************************************************
+ * module port functions
+ */
+
+static void eq_port_low_freq(struct module *m, const struct event *e) {
+	eq_set_freq(m, 0, e);
+}
+
+static void eq_port_low_gain(struct module *m, const struct event *e) {
+	eq_set_gain(m, 0, e);
+}
+
+static void eq_port_mid1_freq(struct module *m, const struct event *e) {
+	eq_set_freq(m, 1, e);
+}
+
+static void eq_port_mid1_gain(struct module *m, const struct event *e) {
+	eq_set_gain(m, 1, e);
+}
+
+static void eq_port_mid2_freq(struct module *m, const struct event *e) {
+	eq_set_freq(m, 2, e);
+}
+
+static void eq_port_mid2_gain(struct module *m, const struct event *e) {
+	eq_set_gain(m, 2, e);
+}
+
+static void eq_port_high_freq(struct module *m, const struct event *e) {
+	eq_set_freq(m, 3, e);
+}
+
+static void eq_port_high_gain(struct module *m, const struct event *e) {
+	eq_set_gain(m, 3, e);
+}
+
+/******************************************************************************
+ * module functions
+ */
+
+static int eq_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct eq *this = ggm_calloc(1, sizeof(struct eq));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	/* flat response */
+	biquad_bank_init(&this->bank);
+	for (int i = 0; i < EQ_BANDS; i++) {
+		this->band[i] = eq_default[i];
+		eq_update(m, i);
+	}
+
+	return 0;
+}
+
+static void eq_free(struct module *m) {
+	struct eq *this = (struct eq *)m->priv;
+
+	ggm_free(this);
+}
+
+static bool eq_process(struct module *m, float *bufs[]) {
+	struct eq *this = (struct eq *)m->priv;
+	float *in = bufs[0];
+	float *out = bufs[1];
+
+	biquad_bank_cascade(&this->bank, in, out);
+	return true;
+}
+
+/******************************************************************************
+ * module information
+ */
+
+static const struct port_info in_ports[] = {
+	{.name = "in",.type = PORT_TYPE_AUDIO,},
+	{.name = "low_freq",.type = PORT_TYPE_FLOAT,.pf = eq_port_low_freq},
+	{.name = "low_gain",.type = PORT_TYPE_FLOAT,.pf = eq_port_low_gain},
+	{.name = "mid1_freq",.type = PORT_TYPE_FLOAT,.pf = eq_port_mid1_freq},
+	{.name = "mid1_gain",.type = PORT_TYPE_FLOAT,.pf = eq_port_mid1_gain},
+	{.name = "mid2_freq",.type = PORT_TYPE_FLOAT,.pf = eq_port_mid2_freq},
+	{.name = "mid2_gain",.type = PORT_TYPE_FLOAT,.pf = eq_port_mid2_gain},
+	{.name = "high_freq",.type = PORT_TYPE_FLOAT,.pf = eq_port_high_freq},
+	{.name = "high_gain",.type = PORT_TYPE_FLOAT,.pf = eq_port_high_gain},
+	PORT_EOL,
+};
+
+static const struct port_info out_ports[] = {
+	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+const struct module_info filter_eq_module = {
+	.mname = "filter/eq",
+	.iname = "eq",
+	.in = in_ports,
+	.out = out_ports,
+	.alloc = eq_alloc,
+	.free = eq_free,
+	.process = eq_process,
+};
+
+MODULE_REGISTER(filter_eq_module);
+
+/*****************************************************************************/
@@ -18,6 +18,20 @@ enum {
 	SVF_TYPE_MAX		/* must be last */
 };
 
+/******************************************************************************
+ * SVF outputs (in output port order)
+ */
+
+enum {
+	SVF_OUT_LP,		/* low pass */
+	SVF_OUT_BP,		/* band pass */
+	SVF_OUT_HP,		/* high pass */
+	SVF_OUT_NOTCH,		/* notch */
+	SVF_OUT_PEAK,		/* peak */
+	SVF_OUT_AP,		/* all pass */
+	SVF_OUTPUTS		/* must be last */
+};
+
 /*****************************************************************************/
 
 #endif				/* GGM_SRC_MODULE_FILTER_FILTER_H */
@@ -10,6 +10,14 @@
  *
  * SVF_TYPE_TRAPEZOIDAL:
  * See: https://cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
+ *
+ * The cutoff is set by the "cutoff" event, or per sample by the optional
+ * "fc" audio input (Hz). Pass a NULL "fc" buffer when it is not used.
+ *
+ * The low pass, band pass and high pass responses come out of the same filter
+ * pass, and the notch, peak and all pass responses are sums of those. They
+ * are all available as outputs. Pass NULL for outputs that are not used,
+ * they are not computed.
  */
 
 #include "ggm.h"
@@ -32,24 +40,50 @@ struct svf {
 	float k;		/* constant for filter resonance */
 	float ic1eq;		/* state variable */
 	float ic2eq;		/*state variable */
+	/* oversampling */
+	float cutoff;		/* cutoff frequency */
+	float kw;		/* cutoff frequency to angle constant */
+	float kx;		/* cutoff frequency to phase constant (for cos_lookup) */
+	float fmax;		/* maximum cutoff frequency */
+	int factor;		/* oversampling factor */
+	struct oversample *os;	/* oversampler (factor > 1) */
+	float *obuf;		/* oversampled output buffers (factor > 1) */
 };
 
 /******************************************************************************
  * svf functions
+ * The cutoff frequency is either constant for the block (kf/g) or comes from
+ * an audio rate cutoff buffer (fc != NULL). The cutoff buffer is at the base
+ * sample rate, so with oversampling each cutoff sample is held for
+ * (1 << shift) filter samples.
+ * The kernels always write the low pass output. The band pass and high pass
+ * outputs are either both written or both NULL.
  */
 
-static void svf_filter_hc(struct module *m, float *in, float *out) {
+static void svf_filter_hc(struct module *m, const float *in, float *lp_out, float *bp_out, float *hp_out, const float *fc, unsigned int shift) {
 	struct svf *this = (struct svf *)m->priv;
 	float lp = this->lp;
 	float bp = this->bp;
 	float kf = this->kf;
 	float kq = this->kq;
 
+	float kx = this->kx;
+	float fmax = this->fmax;
+
 	for (int i = 0; i < AudioBufferSize; i++) {
+		if (fc != NULL) {
+			/* per sample coefficient: 2 * sin(w) = 2 * cos(w - pi/2) */
+			uint32_t x = (uint32_t) (kx * clampf(fc[i >> shift], 0.f, fmax));
+			kf = 2.f * cos_lookup(x - QuarterCycle);
+		}
 		lp += kf * bp;
 		float hp = in[i] - lp - (kq * bp);
 		bp += kf * hp;
-		out[i] = lp;
+		lp_out[i] = lp;
+		if (hp_out != NULL) {
+			bp_out[i] = bp;
+			hp_out[i] = hp;
+		}
 	}
 
 	// update the state variables
@@ -57,49 +91,58 @@ static void svf_filter_hc(struct module *m, float *in, float *out) {
 	this->bp = bp;
 }
 
-static void svf_filter_trapezoidal(struct module *m, float *in, float *out) {
+static void svf_filter_trapezoidal(struct module *m, const float *in, float *lp_out, float *bp_out, float *hp_out, const float *fc, unsigned int shift) {
 	struct svf *this = (struct svf *)m->priv;
 	float ic1eq = this->ic1eq;
 	float ic2eq = this->ic2eq;
-	float a1 = 1.f / (1.f + (this->g * (this->g + this->k)));
-	float a2 = this->g * a1;
-	float a3 = this->g * a2;
+	float g = this->g;
+	float k = this->k;
+	float a1 = 1.f / (1.f + (g * (g + k)));
+	float a2 = g * a1;
+	float a3 = g * a2;
+	float kw = this->kw;
+	float fmax = this->fmax;
 
 	for (int i = 0; i < AudioBufferSize; i++) {
+		if (fc != NULL) {
+			/* per sample coefficients */
+			g = tan_pade(kw * clampf(fc[i >> shift], 0.f, fmax));
+			a1 = 1.f / (1.f + (g * (g + k)));
+			a2 = g * a1;
+			a3 = g * a2;
+		}
 		float v0 = in[i];
 		float v3 = v0 - ic2eq;
 		float v1 = (a1 * ic1eq) + (a2 * v3);
 		float v2 = ic2eq + (a2 * ic1eq) + (a3 * v3);
 		ic1eq = (2.f * v1) - ic1eq;
 		ic2eq = (2.f * v2) - ic2eq;
-		out[i] = v2;	// low
-		// low := v2
-		// band := v1
-		// high := v0 - (this->k * v1) - v2
-		// notch := v0 - (this->k * v1)
-		// peak := v0 - (this->k * v1) - (2.0 * v2)
-		// all := v0 - (2.0 * this->k * v1)
+		lp_out[i] = v2;
+		if (hp_out != NULL) {
+			bp_out[i] = v1;
+			hp_out[i] = v0 - (k * v1) - v2;
+		}
 	}
 	// update the state variables
 	this->ic1eq = ic1eq;
 	this->ic2eq = ic2eq;
 }
 
-/******************************************************************************
- * module port functions
- */
-
-static void svf_port_cutoff(struct module *m, const struct event *e) {
+/* svf_set_cutoff sets the cutoff constants for the (oversampled) sample rate */
+static void svf_set_cutoff(struct module *m, float cutoff) {
 	struct svf *this = (struct svf *)m->priv;
-	float cutoff = clampf(event_get_float(e), 0.f, 0.5f * AudioSampleFrequency);
 
-	LOG_INF("set cutoff frequency %f Hz", cutoff);
+	/* cutoff frequency to angle */
+	this->kw = Pi * AudioSamplePeriod / (float)this->factor;
+	this->kx = 0.5f * FrequencyScale / (float)this->factor;
+	this->fmax = 0.49f * AudioSampleFrequency;
+	this->cutoff = cutoff;
 	switch (this->type) {
 	case SVF_TYPE_HC:
-		this->kf = 2.f * sinf(Pi * cutoff * AudioSamplePeriod);
+		this->kf = 2.f * sinf(this->kw * cutoff);
 		break;
 	case SVF_TYPE_TRAPEZOIDAL:
-		this->g = tanf(Pi * cutoff * AudioSamplePeriod);
+		this->g = tan_pade(this->kw * clampf(cutoff, 0.f, this->fmax));
 		break;
 	default:
 		LOG_ERR("bad filter type %d", this->type);
@@ -107,6 +150,17 @@ static void svf_port_cutoff(struct module *m, const struct event *e) {
 	}
 }
 
+/******************************************************************************
+ * module port functions
+ */
+
+static void svf_port_cutoff(struct module *m, const struct event *e) {
+	float cutoff = clampf(event_get_float(e), 0.f, 0.5f * AudioSampleFrequency);
+
+	LOG_INF("set cutoff frequency %f Hz", cutoff);
+	svf_set_cutoff(m, cutoff);
+}
+
 static void svf_port_resonance(struct module *m, const struct event *e) {
 	struct svf *this = (struct svf *)m->priv;
 	float resonance = clampf(event_get_float(e), 0.f, 1.f);
@@ -125,6 +179,36 @@ static void svf_port_resonance(struct module *m, const struct event *e) {
 	}
 }
 
+/* svf_port_oversample sets the oversampling factor (1, 2 or 4) */
+static void svf_port_oversample(struct module *m, const struct event *e) {
+	struct svf *this = (struct svf *)m->priv;
+	int factor = event_get_int(e);
+
+	if (factor == this->factor) {
+		return;
+	}
+	oversample_del(this->os);
+	ggm_free(this->obuf);
+	this->os = NULL;
+	this->obuf = NULL;
+	this->factor = 1;
+	if (factor > 1) {
+		this->os = oversample_new(factor, SVF_OUTPUTS);
+		this->obuf = ggm_calloc(SVF_OUTPUTS * AudioBufferSize, sizeof(float));
+		if ((this->os != NULL) && (this->obuf != NULL)) {
+			this->factor = factor;
+		} else {
+			oversample_del(this->os);
+			ggm_free(this->obuf);
+			this->os = NULL;
+			this->obuf = NULL;
+		}
+	}
+	LOG_INF("oversample %dx", this->factor);
+	/* the cutoff constants depend on the sample rate */
+	svf_set_cutoff(m, this->cutoff);
+}
+
 /******************************************************************************
  * module functions
  */
@@ -137,6 +221,7 @@ static int svf_alloc(struct module *m, va_list vargs) {
 		return -1;
 	}
 	m->priv = (void *)this;
+	this->factor = 1;
 
 	/* set the filter type */
 	this->type = va_arg(vargs, int);
@@ -144,6 +229,10 @@ static int svf_alloc(struct module *m, va_list vargs) {
 		LOG_ERR("bad filter type %d", this->type);
 		goto error;
 	}
+	svf_set_cutoff(m, 0.f);
+	/* no resonance (k = 0 would be an undamped resonator) */
+	this->kq = 2.f;
+	this->k = 2.f;
 
 	return 0;
 
@@ -155,24 +244,86 @@ static int svf_alloc(struct module *m, va_list vargs) {
 static void svf_free(struct module *m) {
 	struct svf *this = (struct svf *)m->priv;
 
+	oversample_del(this->os);
+	ggm_free(this->obuf);
 	ggm_free(this);
 }
 
-static bool svf_process(struct module *m, float *bufs[]) {
+/* svf_filter filters a block of AudioBufferSize samples to the non-NULL outputs */
+static void svf_filter(struct module *m, const float *in, float *out[SVF_OUTPUTS], const float *fc, unsigned int shift) {
 	struct svf *this = (struct svf *)m->priv;
-	float *in = bufs[0];
-	float *out = bufs[1];
+	float tmp[3][AudioBufferSize];
+	float *lp = (out[SVF_OUT_LP] != NULL) ? out[SVF_OUT_LP] : tmp[0];
+	float *bp = NULL;
+	float *hp = NULL;
+	float k;
+
+	/* the notch, peak and all pass outputs are derived from lp/bp/hp */
+	if ((out[SVF_OUT_BP] != NULL) || (out[SVF_OUT_HP] != NULL) || (out[SVF_OUT_NOTCH] != NULL) || (out[SVF_OUT_PEAK] != NULL) || (out[SVF_OUT_AP] != NULL)) {
+		bp = (out[SVF_OUT_BP] != NULL) ? out[SVF_OUT_BP] : tmp[1];
+		hp = (out[SVF_OUT_HP] != NULL) ? out[SVF_OUT_HP] : tmp[2];
+	}
 
 	switch (this->type) {
 	case SVF_TYPE_HC:
-		svf_filter_hc(m, in, out);
+		svf_filter_hc(m, in, lp, bp, hp, fc, shift);
+		k = this->kq;
 		break;
 	case SVF_TYPE_TRAPEZOIDAL:
-		svf_filter_trapezoidal(m, in, out);
+		svf_filter_trapezoidal(m, in, lp, bp, hp, fc, shift);
+		k = this->k;
 		break;
 	default:
 		LOG_ERR("bad filter type %d", this->type);
-		break;
+		return;
+	}
+
+	if (out[SVF_OUT_NOTCH] != NULL) {
+		float *y = out[SVF_OUT_NOTCH];
+		for (int i = 0; i < AudioBufferSize; i++) {
+			y[i] = hp[i] + lp[i];
+		}
+	}
+	if (out[SVF_OUT_PEAK] != NULL) {
+		float *y = out[SVF_OUT_PEAK];
+		for (int i = 0; i < AudioBufferSize; i++) {
+			y[i] = hp[i] - lp[i];
+		}
+	}
+	if (out[SVF_OUT_AP] != NULL) {
+		float *y = out[SVF_OUT_AP];
+		for (int i = 0; i < AudioBufferSize; i++) {
+			y[i] = hp[i] + lp[i] - (k * bp[i]);
+		}
+	}
+}
+
+static bool svf_process(struct module *m, float *bufs[]) {
+	struct svf *this = (struct svf *)m->priv;
+	float *in = bufs[0];
+	float *fc = bufs[1];
+	float **out = &bufs[2];
+
+	if (this->os != NULL) {
+		/* filter at the oversampled rate and decimate each connected output */
+		float *x = oversample_up(this->os, in);
+		unsigned int shift = (this->factor == 4) ? 2 : 1;
+		size_t n = AudioBufferSize >> shift;
+		for (int i = 0; i < this->factor; i++) {
+			float *fc_i = (fc == NULL) ? NULL : &fc[i * n];
+			float *y[SVF_OUTPUTS];
+			for (int j = 0; j < SVF_OUTPUTS; j++) {
+				y[j] = (out[j] == NULL) ? NULL : &this->obuf[j * AudioBufferSize];
+			}
+			svf_filter(m, &x[i * AudioBufferSize], y, fc_i, shift);
+			for (int j = 0; j < SVF_OUTPUTS; j++) {
+				if (out[j] != NULL) {
+					oversample_down_ch(this->os, j, y[j], &out[j][i * n], n);
+				}
+			}
+		}
+	} else {
+		svf_filter(m, in, out, fc, 0);
 	}
 	return true;
 }
@@ -183,13 +334,20 @@ static bool svf_process(struct module *m, float *bufs[]) {
 
 static const struct port_info in_ports[] = {
 	{.name = "in",.type = PORT_TYPE_AUDIO,},
+	{.name = "fc",.type = PORT_TYPE_AUDIO,},
 	{.name = "cutoff",.type = PORT_TYPE_FLOAT,.pf = svf_port_cutoff},
 	{.name = "resonance",.type = PORT_TYPE_FLOAT,.pf = svf_port_resonance},
+	{.name = "oversample",.type = PORT_TYPE_INT,.pf = svf_port_oversample},
 	PORT_EOL,
 };
 
 static const struct port_info out_ports[] = {
-	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	{.name = "out",.type = PORT_TYPE_AUDIO,},	/* low pass */
+	{.name = "bp",.type = PORT_TYPE_AUDIO,},
+	{.name = "hp",.type = PORT_TYPE_AUDIO,},
+	{.name = "notch",.type = PORT_TYPE_AUDIO,},
+	{.name = "peak",.type = PORT_TYPE_AUDIO,},
+	{.name = "ap",.type = PORT_TYPE_AUDIO,},
 	PORT_EOL,
 };
 
@@ -20,6 +20,8 @@ struct voice {
 	struct module *m;	/* the voice module */
 	uint8_t note;		/* the MIDI note for this voice */
 	bool reset;		/* indicates a voice in soft reset mode */
+	bool has_freq;		/* the voice has a "frequency" input port */
+	port_func freq;		/* port function cache */
 };
 
 struct poly {
@@ -27,12 +29,24 @@ struct poly {
 	struct voice voice[MAX_POLYPHONY];	/* voices */
 	int idx;		/* round robin voice index */
 	float bend;		/* pitch bend value for all voices */
+	float ratio;		/* pitch bend frequency ratio for all voices */
 };
 
 /******************************************************************************
  * voice functions
  */
 
+/* voice_pitch sets the pitch bent note of a voice */
+static void voice_pitch(struct poly *this, struct voice *v) {
+	if (v->has_freq) {
+		/* table lookup and a multiply */
+		float f = midi_note_frequency(v->note) * this->ratio;
+		event_in_float(v->m, "frequency", f, &v->freq);
+	} else {
+		event_in_float(v->m, "note", (float)(v->note) + this->bend, NULL);
+	}
+}
+
 /* voice_lookup returns the voice module for this MIDI note (or NULL) */
 static struct voice *voice_lookup(struct module *m, uint8_t note) {
 	struct poly *this = (struct poly *)m->priv;
@@ -63,9 +77,9 @@ static struct voice *voice_alloc(struct module *m, uint8_t note) {
 	event_in_bool(v->m, "reset", true, NULL);
 
 	/* set the voice note */
-	event_in_float(v->m, "note", (float)note + this->bend, NULL);
 	v->note = note;
 	v->reset = false;
+	voice_pitch(this, v);
 
 	/* Send a soft reset to the next voice so it will be idle
 	 * when we need to use it.
@@ -115,10 +129,11 @@ static void poly_port_midi(struct module *m, const struct event *e) {
 	case MIDI_STATUS_PITCHWHEEL:{
 			/* get the pitch bend value */
 			this->bend = midi_pitch_bend(event_get_midi_pitch_wheel(e));
+			/* the bend ratio is common to all voices */
+			this->ratio = midi_bend_ratio(this->bend);
 			/* update all voices */
 			for (int i = 0; i < MAX_POLYPHONY; i++) {
-				struct voice *v = &this->voice[i];
-				event_in_float(v->m, "note", (float)(v->note) + this->bend, NULL);
+				voice_pitch(this, &this->voice[i]);
 			}
 			break;
 		}
@@ -150,6 +165,7 @@ static int poly_alloc(struct module *m, va_list vargs) {
 
 	/* get the MIDI channel */
 	this->ch = va_arg(vargs, int);
+	this->ratio = 1.f;
 
 	/* allocate the voices */
 	module_func new_voice = va_arg(vargs, module_func);
@@ -158,6 +174,8 @@ static int poly_alloc(struct module *m, va_list vargs) {
 		if (this->voice[i].m == NULL) {
 			goto error;
 		}
+		/* can we set the voice frequency directly? */
+		this->voice[i].has_freq = port_get_index(this->voice[i].m->info->in, "frequency") >= 0;
 	}
 
 	return 0;
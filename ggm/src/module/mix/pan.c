@@ -5,6 +5,11 @@
  *
  * Left/Right Pan and Volume Module
  * Takes a single audio buffer stream as input and outputs left and right channels.
+ *
+ * Volume/pan changes are smoothed with an exponential approach to the target
+ * gains. The approach is evaluated at the block boundaries (so the time
+ * constant doesn't depend on the block size) and the gain is ramped linearly
+ * across each block, so there is no stepping at block boundaries.
  */
 
 #include "ggm.h"
@@ -13,7 +18,14 @@
  * private state
  */
 
+/* PAN_SMOOTH_TIME is the time constant for volume/pan changes (secs) */
+#define PAN_SMOOTH_TIME (0.25f)
+
+/* PAN_SNAP is the gain error where the ramp snaps to the target gain */
+#define PAN_SNAP (1e-5f)
+
 struct pan {
+	float ks;		/* smoothing coefficient per block */
 	float vol;		/* overall volume */
 	float pan;		/* pan value 0 == left, 1 == right */
 	float new_vol_l;	/* target left channel volume */
@@ -62,6 +74,23 @@ static void pan_port_pan(struct module *m, const struct event *e) {
 	pan_set(m);
 }
 
+/******************************************************************************
+ * pan functions
+ */
+
+/* pan_smooth returns the gain at the end of the block and sets the per sample ramp */
+static float pan_smooth(struct pan *this, float vol, float target, float *dk) {
+	float err = target - vol;
+
+	if (fabsf(err) < PAN_SNAP) {
+		*dk = err * (1.f / (float)AudioBufferSize);
+		return target;
+	}
+	err *= this->ks;
+	*dk = err * (1.f / (float)AudioBufferSize);
+	return vol + err;
+}
+
 /******************************************************************************
  * module functions
  */
@@ -75,6 +104,9 @@ static int pan_alloc(struct module *m, va_list vargs) {
 	}
 	m->priv = (void *)this;
 
+	/* 1 - e^(-t/T) for a block */
+	this->ks = 1.f - powe(-SecsPerAudioBuffer / PAN_SMOOTH_TIME);
+
 	/* set some default values */
 	event_in_float(m, "vol", 1.f, NULL);
 	event_in_float(m, "pan", 0.5f, NULL);
@@ -94,15 +126,23 @@ static bool pan_process(struct module *m, float *bufs[]) {
 	float *out0 = bufs[1];
 	float *out1 = bufs[2];
 
-	/* use a proportional update to control the actual channel volume */
-	float err_l = this->new_vol_l - this->vol_l;
-	float err_r = this->new_vol_r - this->vol_r;
+	float dkl, dkr;
+	float vol_l = this->vol_l;
+	float vol_r = this->vol_r;
 
-	this->vol_l += 0.01f * err_l;
-	this->vol_r += 0.01f * err_r;
+	this->vol_l = pan_smooth(this, vol_l, this->new_vol_l, &dkl);
+	this->vol_r = pan_smooth(this, vol_r, this->new_vol_r, &dkr);
 
-	block_copy_mul_k(out0, in, this->vol_l);
-	block_copy_mul_k(out1, in, this->vol_r);
+	if (dkl == 0.f) {
+		block_copy_mul_k(out0, in, vol_l);
+	} else {
+		block_copy_mul_ramp(out0, in, vol_l, dkl);
+	}
+	if (dkr == 0.f) {
+		block_copy_mul_k(out1, in, vol_r);
+	} else {
+		block_copy_mul_ramp(out1, in, vol_r, dkr);
+	}
 	return true;
 }
 
@@ -0,0 +1,463 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * FM Operator Voice
+ *
+ * A 4 or 6 operator (module argument) phase modulation voice with
+ * selectable algorithms. Each operator is a cosine oscillator (cos_lookup()
+ * phase convention) with a frequency ratio, an output level and an env/adsr
+ * envelope. The envelopes are sub-modules (adsr0..adsrN) so they can be set
+ * up with the usual synth configuration paths.
+ *
+ * The operators of a voice are held in FM_LANES wide arrays and each sample
+ * is computed for all operators at once: modulation sums, phase steps, phase
+ * modulation and envelope gains are fixed length loops the compiler maps
+ * onto SIMD lanes. To make that possible an operator is modulated by the
+ * previous sample of its modulators (rather than the current sample as in
+ * a serial implementation). At audio rates this is a small phase shift of
+ * the modulator.
+ *
+ * Operator feedback uses the average of the last two outputs of the
+ * feedback operator, which keeps high feedback levels from oscillating.
+ */
+
+#include "ggm.h"
+
+/******************************************************************************
+ * algorithms
+ * mod[i] is the set of operators that modulate operator i. Operators are
+ * numbered from 0 (DX style op1 is operator 0).
+ */
+
+#define FM_MAX_OPS 6
+#define FM_LANES 8		/* FM_MAX_OPS rounded up to a SIMD width */
+#define FM_ALGORITHMS 8
+
+#define OP(n) (1 << (n))
+
+struct fm_algorithm {
+	uint8_t mod[FM_MAX_OPS];	/* modulators for each operator */
+	uint8_t carriers;	/* operators summed to the output */
+	int fb;			/* operator with feedback */
+};
+
+static const struct fm_algorithm fm_algorithms4[FM_ALGORITHMS] = {
+	/* 4 -> 3 -> 2 -> 1 */
+	{.mod = {OP(1), OP(2), OP(3), 0,},.carriers = OP(0),.fb = 3},
+	/* (3 + 4) -> 2 -> 1 */
+	{.mod = {OP(1), OP(2) | OP(3), 0, 0,},.carriers = OP(0),.fb = 3},
+	/* (2 + (4 -> 3)) -> 1 */
+	{.mod = {OP(1) | OP(2), 0, OP(3), 0,},.carriers = OP(0),.fb = 3},
+	/* ((4 -> 2) + 3) -> 1 */
+	{.mod = {OP(1) | OP(2), OP(3), 0, 0,},.carriers = OP(0),.fb = 3},
+	/* 2 -> 1, 4 -> 3 */
+	{.mod = {OP(1), 0, OP(3), 0,},.carriers = OP(0) | OP(2),.fb = 3},
+	/* 4 -> (1, 2, 3) */
+	{.mod = {OP(3), OP(3), OP(3), 0,},.carriers = OP(0) | OP(1) | OP(2),.fb = 3},
+	/* 1, 2, 4 -> 3 */
+	{.mod = {0, 0, OP(3), 0,},.carriers = OP(0) | OP(1) | OP(2),.fb = 3},
+	/* 1, 2, 3, 4 */
+	{.mod = {0, 0, 0, 0,},.carriers = OP(0) | OP(1) | OP(2) | OP(3),.fb = 3},
+};
+
+static const struct fm_algorithm fm_algorithms6[FM_ALGORITHMS] = {
+	/* DX7 #1: 2 -> 1, 6 -> 5 -> 4 -> 3 */
+	{.mod = {OP(1), 0, OP(3), OP(4), OP(5), 0,},.carriers = OP(0) | OP(2),.fb = 5},
+	/* DX7 #2: as #1 with feedback on 2 */
+	{.mod = {OP(1), 0, OP(3), OP(4), OP(5), 0,},.carriers = OP(0) | OP(2),.fb = 1},
+	/* DX7 #5: 2 -> 1, 4 -> 3, 6 -> 5 */
+	{.mod = {OP(1), 0, OP(3), 0, OP(5), 0,},.carriers = OP(0) | OP(2) | OP(4),.fb = 5},
+	/* DX7 #7: 2 -> 1, (4 + (6 -> 5)) -> 3 */
+	{.mod = {OP(1), 0, OP(3) | OP(4), 0, OP(5), 0,},.carriers = OP(0) | OP(2),.fb = 5},
+	/* DX7 #16: (2 + (4 -> 3) + (6 -> 5)) -> 1 */
+	{.mod = {OP(1) | OP(2) | OP(4), 0, OP(3), 0, OP(5), 0,},.carriers = OP(0),.fb = 5},
+	/* DX7 #22: 2 -> 1, 6 -> (3, 4, 5) */
+	{.mod = {OP(1), 0, OP(5), OP(5), OP(5), 0,},.carriers = OP(0) | OP(2) | OP(3) | OP(4),.fb = 5},
+	/* DX7 #31: 1, 2, 3, 4, 6 -> 5 */
+	{.mod = {0, 0, 0, 0, OP(5), 0,},.carriers = OP(0) | OP(1) | OP(2) | OP(3) | OP(4),.fb = 5},
+	/* DX7 #32: 1, 2, 3, 4, 5, 6 */
+	{.mod = {0, 0, 0, 0, 0, 0,},.carriers = OP(0) | OP(1) | OP(2) | OP(3) | OP(4) | OP(5),.fb = 5},
+};
+
+/******************************************************************************
+ * private state
+ */
+
+/* FM_MAX_INDEX is the peak phase deviation (cycles) of a full level modulator */
+#define FM_MAX_INDEX (2.f)
+
+/* FM_MAX_FEEDBACK is the peak phase deviation (cycles) of full feedback */
+#define FM_MAX_FEEDBACK (0.5f)
+
+struct fm {
+	int ops;		/* number of operators */
+	int algorithm;		/* current algorithm */
+	float freq;		/* base frequency */
+	float kfb;		/* feedback gain (cycles) */
+	float yfb;		/* previous feedback operator output */
+	struct module *adsr[FM_MAX_OPS];	/* operator envelopes */
+	float ratio[FM_MAX_OPS];	/* operator frequency ratios */
+	float level[FM_LANES];	/* operator output levels */
+	float carrier[FM_LANES];	/* operator output mix */
+	float mtx[FM_LANES][FM_LANES];	/* mtx[j][i]: operator j modulation of operator i (cycles) */
+	uint32_t x[FM_LANES];	/* operator phases */
+	uint32_t xstep[FM_LANES];	/* operator phase steps */
+	float y[FM_LANES];	/* operator outputs (previous sample) */
+};
+
+/******************************************************************************
+ * fm functions
+ */
+
+/* fm_set_frequency sets the operator phase steps for a base frequency */
+static void fm_set_frequency(struct fm *this, float freq) {
+	this->freq = freq;
+	for (int i = 0; i < this->ops; i++) {
+		this->xstep[i] = (uint32_t) (freq * this->ratio[i] * FrequencyScale);
+	}
+}
+
+/* fm_set_algorithm sets the modulation matrix and output mix for an algorithm */
+static void fm_set_algorithm(struct fm *this, int n) {
+	const struct fm_algorithm *a = (this->ops == 4) ? &fm_algorithms4[n] : &fm_algorithms6[n];
+	int carriers = 0;
+
+	this->algorithm = n;
+	memset(this->mtx, 0, sizeof(this->mtx));
+	memset(this->carrier, 0, sizeof(this->carrier));
+	for (int i = 0; i < this->ops; i++) {
+		for (int j = 0; j < this->ops; j++) {
+			if (a->mod[i] & OP(j)) {
+				this->mtx[j][i] = FM_MAX_INDEX;
+			}
+		}
+		if (a->carriers & OP(i)) {
+			carriers++;
+		}
+	}
+	/* normalise the output level */
+	for (int i = 0; i < this->ops; i++) {
+		if (a->carriers & OP(i)) {
+			this->carrier[i] = 1.f / (float)carriers;
+		}
+	}
+	this->yfb = 0.f;
+}
+
+/* fm_reset resets the operator phases */
+static void fm_reset(struct fm *this) {
+	for (int i = 0; i < FM_LANES; i++) {
+		/* start at a phase that gives a zero output */
+		this->x[i] = QuarterCycle;
+		this->y[i] = 0.f;
+	}
+	this->yfb = 0.f;
+}
+
+/* fm_render generates a block with the operators in lanes lanes */
+static inline void fm_render(struct fm *this, float *out, float env[FM_MAX_OPS][AudioBufferSize], int lanes) {
+	const struct fm_algorithm *a = (this->ops == 4) ? &fm_algorithms4[this->algorithm] : &fm_algorithms6[this->algorithm];
+	int ops = this->ops;
+	int fb = a->fb;
+	float kfb = this->kfb;
+	float yfb = this->yfb;
+	/* local copies of the state, so it isn't reloaded for each sample */
+	float mtx[FM_LANES][FM_LANES];
+	float level[FM_LANES];
+	float carrier[FM_LANES];
+	uint32_t x[FM_LANES];
+	uint32_t xstep[FM_LANES];
+	float y[FM_LANES];
+
+	memcpy(mtx, this->mtx, sizeof(mtx));
+	memcpy(level, this->level, sizeof(level));
+	memcpy(carrier, this->carrier, sizeof(carrier));
+	memcpy(x, this->x, sizeof(x));
+	memcpy(xstep, this->xstep, sizeof(xstep));
+	memcpy(y, this->y, sizeof(y));
+
+	for (int i = 0; i < AudioBufferSize; i++) {
+		float mod[FM_LANES];
+		float g[FM_LANES];
+		uint32_t ph[FM_LANES];
+
+		/* modulation from the previous operator outputs */
+		for (int l = 0; l < lanes; l++) {
+			mod[l] = 0.f;
+		}
+		for (int j = 0; j < ops; j++) {
+			float yj = y[j];
+			for (int l = 0; l < lanes; l++) {
+				mod[l] += mtx[j][l] * yj;
+			}
+		}
+		mod[fb] += kfb * (y[fb] + yfb);
+		yfb = y[fb];
+
+		/* Step and modulate the phases. The modulation is reduced to
+		 * -1..1 cycles and scaled to +/- HalfCycle so it converts to an
+		 * int32_t, then doubled to a full phase offset.
+		 */
+		for (int l = 0; l < lanes; l++) {
+			float c = mod[l] - (float)(int32_t) mod[l];
+			ph[l] = x[l] + ((uint32_t) (int32_t) (c * (float)HalfCycle) << 1);
+			x[l] += xstep[l];
+		}
+
+		/* operator outputs */
+		for (int l = 0; l < ops; l++) {
+			g[l] = env[l][i] * level[l];
+		}
+		float sum = 0.f;
+		for (int l = 0; l < ops; l++) {
+			y[l] = g[l] * cos_lookup(ph[l]);
+			sum += carrier[l] * y[l];
+		}
+		out[i] = sum;
+	}
+
+	memcpy(this->x, x, sizeof(x));
+	memcpy(this->y, y, sizeof(y));
+	this->yfb = yfb;
+}
+
+/******************************************************************************
+ * module port functions
+ */
+
+/* fm_port_reset resets the voice state */
+static void fm_port_reset(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+
+	for (int i = 0; i < this->ops; i++) {
+		event_in(this->adsr[i], "reset", e, NULL);
+	}
+	if (event_get_bool(e)) {
+		LOG_DBG("%s:reset phase", m->name);
+		fm_reset(this);
+	}
+}
+
+/* fm_port_gate is the voice gate event */
+static void fm_port_gate(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+
+	for (int i = 0; i < this->ops; i++) {
+		event_in(this->adsr[i], "gate", e, NULL);
+	}
+}
+
+/* fm_port_frequency sets the voice frequency (Hz) */
+static void fm_port_frequency(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+	float freq = clampf_lo(event_get_float(e), 0.f);
+
+	LOG_DBG("%s:frequency %f Hz", m->name, freq);
+	fm_set_frequency(this, freq);
+}
+
+/* fm_port_note is the pitch bent MIDI note (float) used to set the voice frequency */
+static void fm_port_note(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+	float note = event_get_float(e);
+
+	LOG_DBG("%s:note %f", m->name, note);
+	fm_set_frequency(this, midi_to_frequency(note));
+}
+
+/* fm_port_algorithm sets the operator algorithm */
+static void fm_port_algorithm(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+	int n = event_get_int(e);
+
+	if ((n < 0) || (n >= FM_ALGORITHMS)) {
+		LOG_ERR("%s:bad algorithm %d", m->name, n);
+		return;
+	}
+	LOG_INF("%s:algorithm %d", m->name, n);
+	fm_set_algorithm(this, n);
+}
+
+/* fm_port_feedback sets the feedback level (0..1) */
+static void fm_port_feedback(struct module *m, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+	float fb = clampf(event_get_float(e), 0.f, 1.f);
+
+	LOG_INF("%s:feedback %f", m->name, fb);
+	/* the feedback term is the sum of two outputs */
+	this->kfb = 0.5f * fb * FM_MAX_FEEDBACK;
+}
+
+/* fm_set_ratio sets the frequency ratio of an operator */
+static void fm_set_ratio(struct module *m, int op, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+
+	if (op >= this->ops) {
+		return;
+	}
+	this->ratio[op] = clampf(event_get_float(e), 0.f, 32.f);
+	LOG_INF("%s:ratio%d %f", m->name, op, this->ratio[op]);
+	fm_set_frequency(this, this->freq);
+}
+
+/* fm_set_level sets the output level of an operator (0..1) */
+static void fm_set_level(struct module *m, int op, const struct event *e) {
+	struct fm *this = (struct fm *)m->priv;
+
+	if (op >= this->ops) {
+		return;
+	}
+	this->level[op] = clampf(event_get_float(e), 0.f, 1.f);
+	LOG_INF("%s:level%d %f", m->name, op, this->level[op]);
+}
+
+/* FM_OP_PORTS defines the ratio/level port functions for an operator */
+#define FM_OP_PORTS(n) \
+static void fm_port_ratio##n(struct module *m, const struct event *e) { \
+	fm_set_ratio(m, n, e); \
+} \
+static void fm_port_level##n(struct module *m, const struct event *e) { \
+	fm_set_level(m, n, e); \
+}
+
+FM_OP_PORTS(0)
+FM_OP_PORTS(1)
+FM_OP_PORTS(2)
+FM_OP_PORTS(3)
+FM_OP_PORTS(4)
+FM_OP_PORTS(5)
+
+/******************************************************************************
+ * module functions
+ */
+
+static int fm_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct fm *this = ggm_calloc(1, sizeof(struct fm));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	/* number of operators */
+	int ops = va_arg(vargs, int);
+	if ((ops != 4) && (ops != 6)) {
+		LOG_ERR("bad number of operators %d", ops);
+		goto error;
+	}
+	this->ops = ops;
+
+	/* operator envelopes */
+	for (int i = 0; i < ops; i++) {
+		this->adsr[i] = module_new(m, "env/adsr", i);
+		if (this->adsr[i] == NULL) {
+			goto error;
+		}
+		/* the envelopes don't need audio rate accuracy */
+		event_in_bool(this->adsr[i], "control", true, NULL);
+	}
+
+	/* defaults: unison ratios, half level operators */
+	for (int i = 0; i < ops; i++) {
+		this->ratio[i] = 1.f;
+		this->level[i] = 0.5f;
+	}
+	fm_set_algorithm(this, 0);
+	fm_reset(this);
+	return 0;
+
+ error:
+	for (int i = 0; i < FM_MAX_OPS; i++) {
+		module_del(this->adsr[i]);
+	}
+	ggm_free(this);
+	return -1;
+}
+
+static void fm_free(struct module *m) {
+	struct fm *this = (struct fm *)m->priv;
+
+	for (int i = 0; i < this->ops; i++) {
+		module_del(this->adsr[i]);
+	}
+	ggm_free(this);
+}
+
+static bool fm_process(struct module *m, float *bufs[]) {
+	struct fm *this = (struct fm *)m->priv;
+	const struct fm_algorithm *a = (this->ops == 4) ? &fm_algorithms4[this->algorithm] : &fm_algorithms6[this->algorithm];
+	float *out = bufs[0];
+	float env[FM_MAX_OPS][AudioBufferSize];
+	bool active = false;
+
+	/* operator envelopes */
+	for (int i = 0; i < this->ops; i++) {
+		struct module *adsr = this->adsr[i];
+		if (adsr->info->process(adsr, (float *[]) { env[i], })) {
+			/* the voice is active while a carrier is active */
+			active |= (a->carriers & OP(i)) != 0;
+		} else {
+			block_zero(env[i]);
+		}
+	}
+
+	if (!active) {
+		return false;
+	}
+
+	/* generate with the smallest lane width for the operators */
+	if (this->ops == 4) {
+		fm_render(this, out, env, 4);
+	} else {
+		fm_render(this, out, env, FM_LANES);
+	}
+	return true;
+}
+
+/******************************************************************************
+ * module information
+ */
+
+static const struct port_info in_ports[] = {
+	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = fm_port_reset},
+	{.name = "gate",.type = PORT_TYPE_FLOAT,.pf = fm_port_gate},
+	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = fm_port_note},
+	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = fm_port_frequency},
+	{.name = "algorithm",.type = PORT_TYPE_INT,.pf = fm_port_algorithm},
+	{.name = "feedback",.type = PORT_TYPE_FLOAT,.pf = fm_port_feedback},
+	{.name = "ratio0",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio0},
+	{.name = "ratio1",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio1},
+	{.name = "ratio2",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio2},
+	{.name = "ratio3",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio3},
+	{.name = "ratio4",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio4},
+	{.name = "ratio5",.type = PORT_TYPE_FLOAT,.pf = fm_port_ratio5},
+	{.name = "level0",.type = PORT_TYPE_FLOAT,.pf = fm_port_level0},
+	{.name = "level1",.type = PORT_TYPE_FLOAT,.pf = fm_port_level1},
+	{.name = "level2",.type = PORT_TYPE_FLOAT,.pf = fm_port_level2},
+	{.name = "level3",.type = PORT_TYPE_FLOAT,.pf = fm_port_level3},
+	{.name = "level4",.type = PORT_TYPE_FLOAT,.pf = fm_port_level4},
+	{.name = "level5",.type = PORT_TYPE_FLOAT,.pf = fm_port_level5},
+	PORT_EOL,
+};
+
+static const struct port_info out_ports[] = {
+	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+const struct module_info osc_fm_module = {
+	.mname = "osc/fm",
+	.iname = "fm",
+	.in = in_ports,
+	.out = out_ports,
+	.alloc = fm_alloc,
+	.free = fm_free,
+	.process = fm_process,
+};
+
+MODULE_REGISTER(osc_fm_module);
+
+/*****************************************************************************/
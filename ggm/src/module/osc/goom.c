@@ -5,18 +5,9 @@
  *
  * Goom Waves
  *
- * A Goom Wave is a wave shape with the following segments:
- *
- * 1) s0: A falling (1 to -1) sine curve
- * 2) f0: A flat piece at the bottom
- * 3) s1: A rising (-1 to 1) sine curve
- * 4) f1: A flat piece at the top
- *
- * Shape is controlled by two parameters:
- * duty = split the total period between s0,f0 and s1,f1
- * slope = split s0f0 and s1f1 between slope and flat.
- *
- * The idea for goom waves comes from: https://www.quinapalus.com/goom.html
+ * A goom wave oscillator (see core/goom.c for the wave shape). The phases
+ * come from the shared phase generator with optional fm/pm audio inputs,
+ * and the wave can be generated at 2x/4x the sample rate and decimated.
  */
 
 #include "ggm.h"
@@ -29,63 +20,29 @@ struct goom {
 	float freq;		/* base frequency */
 	float duty;		/* wave duty cycle */
 	float slope;		/* wave slope */
-	float tp;		/* s0f0 to s1f1 transition point */
-	float k0;		/* scaling factor for slope 0 */
-	float k1;		/* scaling factor for slope 1 */
+	struct goom_wave w;	/* wave shape */
 	uint32_t x;		/* phase position */
-	uint32_t xstep;		/* phase step per sample */
-	uint32_t xreset;	/* phase value for zero output */
+	int factor;		/* oversampling factor */
+	struct oversample *os;	/* oversampler (factor > 1) */
 };
 
 /******************************************************************************
  * goom functions
  */
 
-/* goom_sample returns a single sample for the current phase value. */
-static float goom_sample(struct module *m) {
-	struct goom *this = (struct goom *)m->priv;
-	uint32_t ofs = 0;
-	float x;
-
-	/* what portion of the goom wave are we in? */
-	if (this->x < this->tp) {
-		/* we are in the s0/f0 portion */
-		x = (float)(this->x) * this->k0;
-	} else {
-		/* we are in the s1/f1 portion */
-		x = (float)(this->x - this->tp) * this->k1;
-		ofs = HalfCycle;
-	}
-	// clamp x to 1
-	if (x > 1.f) {
-		x = 1.f;
-	}
-	return cos_lookup((uint32_t) (x * (float)HalfCycle) + ofs);
-}
-
 static void goom_set_shape(struct module *m, float duty, float slope) {
 	struct goom *this = (struct goom *)m->priv;
 
-	/* update duty cycle */
 	this->duty = duty;
-	this->tp = (uint32_t) ((float)FullCycle * map_lin(duty, 0.05f, 0.5f));
-	/* update the slope */
 	this->slope = slope;
-	/* Work out the portion of s0f0/s1f1 that is sloped. */
-	slope = map_lin(slope, 0.1f, 1.f);
-	/* scaling constant for s0, map the slope to the LUT. */
-	this->k0 = 1.f / ((float)(this->tp) * slope);
-	/* scaling constant for s1, map the slope to the LUT. */
-	this->k1 = 1.f / ((float)(FullCycle - 1 - this->tp) * slope);
-	/* this phase reset value gives zero output */
-	this->xreset = (uint32_t) ((float)(this->tp) * slope * 0.5f);
+	goom_wave_shape(&this->w, duty, slope);
 }
 
 static void goom_set_frequency(struct module *m, float freq) {
 	struct goom *this = (struct goom *)m->priv;
 
 	this->freq = freq;
-	this->xstep = (uint32_t) (freq * FrequencyScale);
+	goom_wave_step(&this->w, (uint32_t) (freq * FrequencyScale / (float)this->factor));
 }
 
 /******************************************************************************
@@ -148,8 +105,30 @@ static void goom_port_reset(struct module *m, const struct event *e) {
 		struct goom *this = (struct goom *)m->priv;
 		LOG_DBG("%s:reset phase", m->name);
 		/* start at a phase that gives a zero output */
-		this->x = this->xreset;
+		this->x = this->w.xreset;
+	}
+}
+
+/* goom_port_oversample sets the oversampling factor (1, 2 or 4) */
+static void goom_port_oversample(struct module *m, const struct event *e) {
+	struct goom *this = (struct goom *)m->priv;
+	int factor = event_get_int(e);
+
+	if (factor == this->factor) {
+		return;
+	}
+	oversample_del(this->os);
+	this->os = NULL;
+	this->factor = 1;
+	if (factor > 1) {
+		this->os = oversample_new(factor, 1);
+		if (this->os != NULL) {
+			this->factor = factor;
+		}
 	}
+	LOG_INF("%s:oversample %dx", m->name, this->factor);
+	/* the phase step depends on the sample rate */
+	goom_set_frequency(m, this->freq);
 }
 
 /******************************************************************************
@@ -164,30 +143,64 @@ static int goom_alloc(struct module *m, va_list vargs) {
 		return -1;
 	}
 	m->priv = (void *)this;
+	this->factor = 1;
 
 	/* set initial shape values */
 	goom_set_shape(m, 0.5f, 0.5f);
 	/* start at a phase that gives a zero output */
-	this->x = this->xreset;
+	this->x = this->w.xreset;
 	return 0;
 }
 
 static void goom_free(struct module *m) {
 	struct goom *this = (struct goom *)m->priv;
 
+	oversample_del(this->os);
 	ggm_free(this);
 }
 
-static bool goom_process(struct module *m, float *bufs[]) {
-	struct goom *this = (struct goom *)m->priv;
-	float *out = bufs[0];
+/* goom_generate generates a block of AudioBufferSize samples with optional
+ * fm/pm modulation buffers (at the generated sample rate).
+ */
+static void goom_generate(struct goom *this, float *out, const float *fm, const float *pm) {
+	uint32_t x[AudioBufferSize];
+
+	phase_gen_mod(x, &this->x, this->w.xstep, fm, pm, FrequencyScale / (float)this->factor, AudioBufferSize);
+	goom_wave_gen(&this->w, x, out);
+}
 
+/* goom_hold repeats each of AudioBufferSize / factor samples factor times */
+static const float *goom_hold(float *dst, const float *src, int factor) {
+	if (src == NULL) {
+		return NULL;
+	}
 	for (int i = 0; i < AudioBufferSize; i++) {
-		out[i] = goom_sample(m);
-		/* step the phase */
-		this->x += this->xstep;
-		// fm: m.x += uint32((m.freq + fm[i]) * core.FrequencyScale)
-		// pm: m.x += uint32(float32(m.xstep) + (pm[i] * core.PhaseScale))
+		dst[i] = src[i / factor];
+	}
+	return dst;
+}
+
+static bool goom_process(struct module *m, float *bufs[]) {
+	struct goom *this = (struct goom *)m->priv;
+	float *fm = bufs[0];
+	float *pm = bufs[1];
+	float *out = bufs[2];
+
+	if (this->os != NULL) {
+		/* generate at the oversampled rate and decimate */
+		int factor = this->factor;
+		float fmx[AudioBufferSize];
+		float pmx[AudioBufferSize];
+		for (int i = 0; i < factor; i++) {
+			/* hold the modulation inputs for the oversampled samples */
+			int ofs = i * (AudioBufferSize / factor);
+			const float *fmi = goom_hold(fmx, (fm != NULL) ? &fm[ofs] : NULL, factor);
+			const float *pmi = goom_hold(pmx, (pm != NULL) ? &pm[ofs] : NULL, factor);
+			goom_generate(this, &this->os->buf[i * AudioBufferSize], fmi, pmi);
+		}
+		oversample_down(this->os, out);
+	} else {
+		goom_generate(this, out, fm, pm);
 	}
 	return true;
 }
@@ -202,6 +215,9 @@ static const struct port_info in_ports[] = {
 	{.name = "duty",.type = PORT_TYPE_FLOAT,.pf = goom_port_duty,.mf = goom_midi_duty},
 	{.name = "slope",.type = PORT_TYPE_FLOAT,.pf = goom_port_slope,.mf = goom_midi_slope},
 	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = goom_port_reset},
+	{.name = "oversample",.type = PORT_TYPE_INT,.pf = goom_port_oversample},
+	{.name = "fm",.type = PORT_TYPE_AUDIO,},
+	{.name = "pm",.type = PORT_TYPE_AUDIO,},
 	PORT_EOL,
 };
 
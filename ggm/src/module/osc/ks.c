@@ -5,14 +5,15 @@
  *
  * Karplus Strong Oscillator Module
  *
- * KS generally has a delay line buffer size that determines the fundamental frequency
- * of the sound. That has some practical problems. The delay line buffer is too
- * large for low frequencies and it makes it hard to provide fine resolution
- * control over the frequency. This implementation uses a fixed buffer size and
- * steps through it with a 32 bit phase value. The step size determines the
- * frequency of the sound. When the step position falls between samples we do
- * linear interpolation to get the output value. When we move beyond a sample
- * we do the low pass filtering on it (in this case simple averaging).
+ * The string is a delay line whose length is the period of the note. Each
+ * sample is averaged with the next one (low pass filter) as it goes around
+ * the loop. The fractional part of the period is made up with a 1st order
+ * allpass filter, so the tuning is accurate for any frequency.
+ *
+ * The delay line is processed in spans up to the wrap point, so the inner
+ * loop has no branches. Only the first (period) samples of the delay line are
+ * used, so the working set of a string is proportional to its period.
+ * KS_MAX_DELAY sets the lowest frequency (~47 Hz for 1024 samples).
  */
 
 #include "ggm.h"
@@ -29,22 +30,23 @@ enum ks_state {
 	KS_STATE_MAX		/* must be last */
 };
 
-#define KS_DELAY_BITS 7
-#define KS_DELAY_SIZE (1 << KS_DELAY_BITS)
+#ifndef KS_MAX_DELAY
+#define KS_MAX_DELAY 1024	/* maximum delay line length (samples) */
+#endif
 
-#define KS_DELAY_MASK (KS_DELAY_SIZE - 1)
-#define KS_FRAC_BITS (32 - KS_DELAY_BITS)
-#define KS_FRAC_MASK ((1 << KS_FRAC_BITS) - 1)
-#define KS_FRAC_SCALE (1.f / (float)(1 << KS_FRAC_BITS))
+#define KS_MIN_DELAY 2		/* minimum delay line length (samples) */
 
 struct ks {
 	int state;		/* string state */
 	uint32_t rand;		/* random state */
-	float delay[KS_DELAY_SIZE];	/* delay line */
 	float kval[KS_STATE_MAX];	/* attenuation per string state */
 	float freq;		/* base frequency */
-	uint32_t x;		/* phase position */
-	uint32_t xstep;		/* phase step per sample */
+	int n;			/* delay line length (samples) */
+	int p;			/* delay line position */
+	float c;		/* allpass coefficient */
+	float x1;		/* allpass input state */
+	float y1;		/* allpass output state */
+	float delay[KS_MAX_DELAY];	/* delay line */
 };
 
 /******************************************************************************
@@ -55,9 +57,24 @@ struct ks {
 static void ks_set_frequency(struct module *m, float freq) {
 	struct ks *this = (struct ks *)m->priv;
 
+	float period;
+	int n;
+
 	LOG_DBG("%s frequency %f", m->name, freq);
 	this->freq = freq;
-	this->xstep = (uint32_t) (freq * FrequencyScale);
+
+	/* The averaging filter reads the next sample in the delay line, so
+	 * period = n - 1/2 (averaging) + d (allpass), 0.5 <= d < 1.5
+	 */
+	period = (freq > 0.f) ? ((float)AudioSampleFrequency / freq) : (float)KS_MAX_DELAY;
+	period = clampf(period, (float)KS_MIN_DELAY, (float)KS_MAX_DELAY);
+	n = (int)period;
+	float d = period + 0.5f - (float)n;
+	this->c = (1.f - d) / (1.f + d);
+	this->n = n;
+	if (this->p >= n) {
+		this->p = 0;
+	}
 }
 
 /* ks_pluck_buffer initialises the delay buffer with random samples
@@ -72,7 +89,7 @@ static void ks_pluck_buffer(struct module *m, float gate) {
 	gate = clampf(gate, 0.f, 1.f);
 	gate = map_exp(gate, 0.f, 1.f, -4);
 
-	for (int i = 0; i < KS_DELAY_SIZE - 1; i++) {
+	for (int i = 0; i < this->n - 1; i++) {
 		float val = gate * randf(&this->rand);
 		float x = sum + val;
 		if ((x > 1.f) || (x < -1.f)) {
@@ -81,16 +98,19 @@ static void ks_pluck_buffer(struct module *m, float gate) {
 		sum += val;
 		this->delay[i] = val;
 	}
-	this->delay[KS_DELAY_SIZE - 1] = -sum;
+	this->delay[this->n - 1] = -sum;
+	this->p = 0;
+	this->x1 = 0.f;
+	this->y1 = 0.f;
 }
 
 /* ks_zero_buffer resets the delay buffer */
 static void ks_zero_buffer(struct module *m) {
 	struct ks *this = (struct ks *)m->priv;
 
-	for (int i = 0; i < KS_DELAY_SIZE - 1; i++) {
-		this->delay[i] = 0.f;
-	}
+	memset(this->delay, 0, sizeof(this->delay));
+	this->x1 = 0.f;
+	this->y1 = 0.f;
 }
 
 /******************************************************************************
@@ -174,6 +194,8 @@ static int ks_alloc(struct module *m, va_list vargs) {
 	this->kval[KS_STATE_RELEASE] = 0.8f * 0.5f;
 	this->kval[KS_STATE_RESET] = 0.1f * 0.1f * 0.5f;
 
+	ks_set_frequency(m, 440.f);
+
 	return 0;
 }
 
@@ -186,30 +208,52 @@ static void ks_free(struct module *m) {
 static bool ks_process(struct module *m, float *bufs[]) {
 	struct ks *this = (struct ks *)m->priv;
 	float *out = bufs[0];
+	float *delay = this->delay;
+	float k = this->kval[this->state];
+	float c = this->c;
+	float x1 = this->x1;
+	float y1 = this->y1;
+	int last = this->n - 1;
+	int p = this->p;
+	int i = 0;
 
 	if (this->state == KS_STATE_IDLE) {
 		/* no output */
 		return false;
 	}
 
-	for (int i = 0; i < AudioBufferSize; i++) {
-		uint32_t x0 = this->x >> KS_FRAC_BITS;
-		uint32_t x1 = (x0 + 1) & KS_DELAY_MASK;
-		float y0 = this->delay[x0];
-		float y1 = this->delay[x1];
-		/* interpolate */
-		out[i] = y0 + (y1 - y0) * KS_FRAC_SCALE * (float)(this->x & KS_FRAC_MASK);
-		/* step the x position */
-		this->x += this->xstep;
-		/* filter: once we have moved beyond the delay line index we
-		 * will average it's amplitude with the next value.
-		 */
-		if (x0 != (this->x >> KS_FRAC_BITS)) {
-			float k = this->kval[this->state];
-			this->delay[x0] = k * (y0 + y1);
+	while (i < AudioBufferSize) {
+		/* span up to the end of the delay line */
+		int n = last - p;
+		if (n > AudioBufferSize - i) {
+			n = AudioBufferSize - i;
+		}
+		for (int j = 0; j < n; j++) {
+			float y0 = delay[p + j];
+			out[i + j] = y0;
+			/* average, attenuate and allpass */
+			float x0 = k * (y0 + delay[p + j + 1]);
+			y1 = (c * (x0 - y1)) + x1;
+			x1 = x0;
+			delay[p + j] = y1;
+		}
+		i += n;
+		p += n;
+		/* the last sample wraps to the start of the delay line */
+		if ((i < AudioBufferSize) && (p == last)) {
+			float y0 = delay[last];
+			out[i++] = y0;
+			float x0 = k * (y0 + delay[0]);
+			y1 = (c * (x0 - y1)) + x1;
+			x1 = x0;
+			delay[last] = y1;
+			p = 0;
 		}
 	}
 
+	this->p = p;
+	this->x1 = x1;
+	this->y1 = y1;
 	return true;
 }
 
@@ -5,6 +5,19 @@
  *
  * Low Freqeuncy Oscillator
  *
+ * The phases for a buffer come from the shared phase generator. Each wave
+ * shape has its own inner loop, selected once per buffer. The
+ * polyBLEP/polyBLAMP band-limiting is a separate pass per shape.
+ *
+ * In control rate mode ("control" = true) the wave is evaluated once per
+ * LFO_CONTROL_BLOCK samples and the output is a linear ramp between those
+ * values. The "level" output sends the last value once per buffer (when
+ * it's connected and the value has moved by more than LFO_LEVEL_DELTA of the
+ * depth) for modulating event driven parameters.
+ *
+ * With "fixed" set the audio rate wave is generated as q15 with integer
+ * operations only and converted to float once (scaled by the depth). The
+ * band-limiting pass is still float. Control rate mode is always float.
  */
 
 #include "ggm.h"
@@ -14,12 +27,25 @@
  * private state
  */
 
+/* samples per control rate step */
+#define LFO_CONTROL_BLOCK 16
+
+/* output port index of the level output */
+#define LFO_PORT_LEVEL 1
+
+/* minimum change (relative to the depth) that sends a level event */
+#define LFO_LEVEL_DELTA (1.f / 256.f)
+
 struct lfo {
 	int shape;		/* wave shape */
 	float depth;		/* wave amplitude */
 	uint32_t x;		/* current x-value */
 	uint32_t xstep;		/* current x-step */
 	uint32_t rand_state;	/* random state for s&h */
+	bool control;		/* control rate mode */
+	bool fixed;		/* q15 processing */
+	float y1;		/* last control rate value */
+	float level;		/* last value sent on the level output */
 };
 
 /******************************************************************************
@@ -50,6 +76,22 @@ static void lfo_port_shape(struct module *m, const struct event *e) {
 	this->shape = shape;
 }
 
+/* lfo_port_control selects control rate (true) or audio rate (false) mode */
+static void lfo_port_control(struct module *m, const struct event *e) {
+	struct lfo *this = (struct lfo *)m->priv;
+
+	this->control = event_get_bool(e);
+	LOG_INF("control rate %d", this->control);
+}
+
+/* lfo_port_fixed selects q15 (true) or float (false) processing */
+static void lfo_port_fixed(struct module *m, const struct event *e) {
+	struct lfo *this = (struct lfo *)m->priv;
+
+	this->fixed = event_get_bool(e);
+	LOG_DBG("%s fixed %d", m->name, this->fixed);
+}
+
 static void lfo_port_sync(struct module *m, const struct event *e) {
 	if (event_get_bool(e)) {
 		struct lfo *this = (struct lfo *)m->priv;
@@ -59,78 +101,274 @@ static void lfo_port_sync(struct module *m, const struct event *e) {
 }
 
 /******************************************************************************
- * module functions
+ * wave shape kernels
+ * Each kernel writes the wave (scaled by depth) for n phases to out.
+ * The waves are calculated as q8.24 values.
  */
 
-static int lfo_alloc(struct module *m, va_list vargs) {
-	/* allocate the private data */
-	struct lfo *this = ggm_calloc(1, sizeof(struct lfo));
+#define Q24_SCALE (1.f / (float)(1 << 24))
 
-	if (this == NULL) {
-		return -1;
+static void lfo_triangle(struct lfo *this, float *out, const uint32_t *x, int n) {
+	float k = this->depth * Q24_SCALE;
+
+	for (int i = 0; i < n; i++) {
+		uint32_t xt = x[i] + (1 << 30);
+		int32_t sample = (int32_t) (xt >> 6);
+		sample ^= -(int32_t) (xt >> 31);
+		sample &= (1 << 25) - 1;
+		sample -= (1 << 24);
+		out[i] = k * (float)sample;
 	}
-	m->priv = (void *)this;
+}
 
-	return 0;
+static void lfo_sawdown(struct lfo *this, float *out, const uint32_t *x, int n) {
+	float k = this->depth * Q24_SCALE;
+
+	for (int i = 0; i < n; i++) {
+		out[i] = k * (float)(-(int32_t) x[i] >> 7);
+	}
 }
 
-static void lfo_free(struct module *m) {
-	ggm_free(m->priv);
+static void lfo_sawup(struct lfo *this, float *out, const uint32_t *x, int n) {
+	float k = this->depth * Q24_SCALE;
+
+	for (int i = 0; i < n; i++) {
+		out[i] = k * (float)((int32_t) x[i] >> 7);
+	}
 }
 
-static float lfo_sample(struct module *m) {
-	struct lfo *this = (struct lfo *)m->priv;
+static void lfo_square(struct lfo *this, float *out, const uint32_t *x, int n) {
+	float k = this->depth * Q24_SCALE;
+
+	for (int i = 0; i < n; i++) {
+		int32_t sample = (int32_t) (x[i] & (1U << 31));
+		sample = (sample >> 6) | (1 << 24);
+		out[i] = k * (float)sample;
+	}
+}
+
+static void lfo_sine(struct lfo *this, float *out, const uint32_t *x, int n) {
+	float k = this->depth;
 
-	/* calculate samples as q8.24 */
-	int32_t sample = 0;
+	for (int i = 0; i < n; i++) {
+		out[i] = k * cos_lookup(x[i] - (1 << 30));
+	}
+}
+
+static void lfo_sampleandhold(struct lfo *this, float *out, const uint32_t *x, int n, uint32_t xstep) {
+	float k = this->depth * Q24_SCALE;
+	uint32_t rand_state = this->rand_state;
+
+	for (int i = 0; i < n; i++) {
+		if (x[i] < xstep) {
+			/* 0..253, cycle length = 128, 64 values with bit 7 = 1 */
+			rand_state = ((rand_state * 179) + 17) & 0xff;
+		}
+		out[i] = k * (float)((int32_t) (rand_state << 24) >> 7);
+	}
+	this->rand_state = rand_state;
+}
+
+/* lfo_wave writes n samples of the current wave shape to out */
+static void lfo_wave(struct lfo *this, float *out, const uint32_t *x, int n, uint32_t xstep) {
+	switch (this->shape) {
+	case LFO_SHAPE_TRIANGLE:
+		lfo_triangle(this, out, x, n);
+		break;
+	case LFO_SHAPE_SAWDOWN:
+		lfo_sawdown(this, out, x, n);
+		break;
+	case LFO_SHAPE_SAWUP:
+		lfo_sawup(this, out, x, n);
+		break;
+	case LFO_SHAPE_SQUARE:
+		lfo_square(this, out, x, n);
+		break;
+	case LFO_SHAPE_SINE:
+		lfo_sine(this, out, x, n);
+		break;
+	case LFO_SHAPE_SAMPLEANDHOLD:
+		lfo_sampleandhold(this, out, x, n, xstep);
+		break;
+	default:
+		/* no shape */
+		for (int i = 0; i < n; i++) {
+			out[i] = 0.f;
+		}
+		break;
+	}
+}
 
+/* lfo_wave_q15 writes a block of the current wave shape (unity amplitude) as q15 */
+static void lfo_wave_q15(struct lfo *this, q15_t * out, const uint32_t *x, uint32_t xstep) {
 	switch (this->shape) {
-	case LFO_SHAPE_TRIANGLE:{
-			uint32_t x = this->x + (1 << 30);
-			sample = (int32_t) (x >> 6);
-			sample ^= -(int32_t) (x >> 31);
-			sample &= (1 << 25) - 1;
-			sample -= (1 << 24);
-			break;
+	case LFO_SHAPE_TRIANGLE:
+		for (int i = 0; i < AudioBufferSize; i++) {
+			uint32_t xt = x[i] + (1 << 30);
+			int32_t sample = (int32_t) (xt >> 15);
+			sample ^= -(int32_t) (xt >> 31);
+			sample &= (1 << 16) - 1;
+			out[i] = (q15_t) (sample - (1 << 15));
 		}
-	case LFO_SHAPE_SAWDOWN:{
-			sample = -(int32_t) (this->x) >> 7;
-			break;
+		break;
+	case LFO_SHAPE_SAWDOWN:
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] = (q15_t) ((int32_t) (0U - x[i]) >> 16);
 		}
-	case LFO_SHAPE_SAWUP:{
-			sample = (int32_t) (this->x) >> 7;
-			break;
+		break;
+	case LFO_SHAPE_SAWUP:
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] = (q15_t) ((int32_t) x[i] >> 16);
 		}
-	case LFO_SHAPE_SQUARE:{
-			sample = (int32_t) (this->x & (1 << 31));
-			sample = (sample >> 6) | (1 << 24);
-			break;
+		break;
+	case LFO_SHAPE_SQUARE:
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] = (x[i] & (1U << 31)) ? Q15_MIN : Q15_MAX;
 		}
-	case LFO_SHAPE_SINE:{
-			uint32_t x = this->x - (1 << 30);
-			return cos_lookup(x);
+		break;
+	case LFO_SHAPE_SINE:
+		{
+			uint32_t xs[AudioBufferSize];
+			for (int i = 0; i < AudioBufferSize; i++) {
+				xs[i] = x[i] - (1 << 30);
+			}
+			cos_lookup_block_q15(xs, out);
 		}
-	case LFO_SHAPE_SAMPLEANDHOLD:{
-			if (this->x < this->xstep) {
-				/* 0..253, cycle length = 128, 64 values with bit 7 = 1 */
-				this->rand_state = ((this->rand_state * 179) + 17) & 0xff;
+		break;
+	case LFO_SHAPE_SAMPLEANDHOLD:
+		{
+			uint32_t rand_state = this->rand_state;
+			for (int i = 0; i < AudioBufferSize; i++) {
+				if (x[i] < xstep) {
+					rand_state = ((rand_state * 179) + 17) & 0xff;
+				}
+				out[i] = (q15_t) ((int32_t) (rand_state << 24) >> 16);
 			}
-			sample = (int32_t) (this->rand_state << 24) >> 7;
-			break;
+			this->rand_state = rand_state;
 		}
+		break;
+	default:
+		/* no shape */
+		block_zero_q15(out);
+		break;
 	}
+}
 
-	/* convert q8.24 to float */
-	return (float)sample / (float)(1 << 24);
+/* lfo_phase writes the phases for n samples with a phase step of xstep.
+ * this->x is the phase of the last sample written.
+ */
+static void lfo_phase(struct lfo *this, uint32_t *x, int n, uint32_t xstep) {
+	uint32_t x0 = this->x + xstep;
+
+	phase_gen(x, &x0, xstep, n);
+	this->x = x0 - xstep;
+}
+
+/******************************************************************************
+ * band-limiting
+ */
+
+/* lfo_blep adds the polyblep/polyblamp corrections for the current wave shape */
+static void lfo_blep(struct lfo *this, float *out, const uint32_t *x) {
+	float dt = blep_phase(this->xstep);
+	float k = this->depth;
+
+	switch (this->shape) {
+	case LFO_SHAPE_TRIANGLE:
+		/* slope changes of -8 at x = 1/4 and +8 at x = 3/4 */
+		k *= 8.f * dt;
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] += k * (polyblamp(blep_phase(x[i] - (3 * QuarterCycle)), dt) - polyblamp(blep_phase(x[i] - QuarterCycle), dt));
+		}
+		break;
+	case LFO_SHAPE_SAWDOWN:
+		/* step of +2 at x = 1/2 */
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] += k * polyblep(blep_phase(x[i] - HalfCycle), dt);
+		}
+		break;
+	case LFO_SHAPE_SAWUP:
+		/* step of -2 at x = 1/2 */
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] -= k * polyblep(blep_phase(x[i] - HalfCycle), dt);
+		}
+		break;
+	case LFO_SHAPE_SQUARE:
+		/* step of +2 at x = 0, step of -2 at x = 1/2 */
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] += k * (polyblep(blep_phase(x[i]), dt) - polyblep(blep_phase(x[i] - HalfCycle), dt));
+		}
+		break;
+	}
+}
+
+/******************************************************************************
+ * module functions
+ */
+
+static int lfo_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct lfo *this = ggm_calloc(1, sizeof(struct lfo));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	return 0;
+}
+
+static void lfo_free(struct module *m) {
+	ggm_free(m->priv);
 }
 
 static bool lfo_process(struct module *m, float *bufs[]) {
 	struct lfo *this = (struct lfo *)m->priv;
 	float *out = bufs[0];
 
-	for (int i = 0; i < AudioBufferSize; i++) {
-		this->x += this->xstep;
-		out[i] = this->depth * lfo_sample(m);
+	uint32_t x[AudioBufferSize];
+
+	if (this->control) {
+		/* evaluate the wave at the control rate and interpolate */
+		uint32_t xstep = this->xstep * LFO_CONTROL_BLOCK;
+		float ctl[AudioBufferSize / LFO_CONTROL_BLOCK];
+		float y0 = this->y1;
+		lfo_phase(this, x, AudioBufferSize / LFO_CONTROL_BLOCK, xstep);
+		lfo_wave(this, ctl, x, AudioBufferSize / LFO_CONTROL_BLOCK, xstep);
+		for (int j = 0; j < AudioBufferSize / LFO_CONTROL_BLOCK; j++) {
+			float dy = (ctl[j] - y0) * (1.f / (float)LFO_CONTROL_BLOCK);
+			float *y = &out[j * LFO_CONTROL_BLOCK];
+			for (int i = 0; i < LFO_CONTROL_BLOCK; i++) {
+				y[i] = y0 + ((float)(i + 1) * dy);
+			}
+			y0 = ctl[j];
+		}
+		this->y1 = y0;
+	} else {
+		lfo_phase(this, x, AudioBufferSize, this->xstep);
+		if (this->fixed) {
+			q15_t y[AudioBufferSize];
+			float k = this->depth * (1.f / 32768.f);
+			lfo_wave_q15(this, y, x, this->xstep);
+			for (int i = 0; i < AudioBufferSize; i++) {
+				out[i] = k * (float)y[i];
+			}
+		} else {
+			lfo_wave(this, out, x, AudioBufferSize, this->xstep);
+		}
+		if ((this->xstep != 0) && (this->xstep <= HalfCycle)) {
+			/* band-limit (not stopped or above nyquist) */
+			lfo_blep(this, out, x);
+		}
+		this->y1 = out[AudioBufferSize - 1];
+	}
+
+	/* send the level once per buffer (if it's connected and has changed) */
+	if ((m->dst[LFO_PORT_LEVEL] != NULL) && (fabsf(this->y1 - this->level) > (LFO_LEVEL_DELTA * this->depth))) {
+		struct event e;
+		event_set_float(&e, this->y1);
+		event_push(m, LFO_PORT_LEVEL, &e);
+		this->level = this->y1;
 	}
 
 	return true;
@@ -145,11 +383,14 @@ static const struct port_info in_ports[] = {
 	{.name = "depth",.type = PORT_TYPE_FLOAT,.pf = lfo_port_depth},
 	{.name = "shape",.type = PORT_TYPE_INT,.pf = lfo_port_shape},
 	{.name = "sync",.type = PORT_TYPE_BOOL,.pf = lfo_port_sync},
+	{.name = "control",.type = PORT_TYPE_BOOL,.pf = lfo_port_control},
+	{.name = "fixed",.type = PORT_TYPE_BOOL,.pf = lfo_port_fixed},
 	PORT_EOL,
 };
 
 static const struct port_info out_ports[] = {
 	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	{.name = "level",.type = PORT_TYPE_FLOAT,},
 	PORT_EOL,
 };
 
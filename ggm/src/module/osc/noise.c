@@ -11,6 +11,8 @@
  * https://en.wikipedia.org/wiki/White_noise
  * https://en.wikipedia.org/wiki/Brownian_noise
  *
+ * The noise is generated a block at a time (see core/noise.c).
+ *
  * Arguments:
  * int, type of noise to generate
  */
@@ -24,9 +26,7 @@
 
 struct noise {
 	int type;		/* noise type */
-	uint32_t rand;		/* random state */
-	float b0, b1, b2, b3;	/* state variables */
-	float b4, b5, b6;	/* state variables */
+	struct noise_gen gen;	/* block noise generator */
 };
 
 /******************************************************************************
@@ -37,80 +37,6 @@ static void noise_port_null(struct module *m, const struct event *e) {
 	// do nothing ...
 }
 
-/******************************************************************************
- * noise generating functions
- */
-
-static void generate_white(struct module *m, float *out) {
-	struct noise *this = (struct noise *)m->priv;
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		out[i] = randf(&this->rand);
-	}
-}
-
-static void generate_brown(struct module *m, float *out) {
-	struct noise *this = (struct noise *)m->priv;
-	float b0 = this->b0;
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		float white = randf(&this->rand);
-		b0 = (b0 + (0.02f * white)) * (1.0f / 1.02f);
-		out[i] = b0 * (1.0f / 0.38f);
-	}
-	this->b0 = b0;
-}
-
-static void generate_pink1(struct module *m, float *out) {
-	struct noise *this = (struct noise *)m->priv;
-	float b0 = this->b0;
-	float b1 = this->b1;
-	float b2 = this->b2;
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		float white = randf(&this->rand);
-		b0 = 0.99765f * b0 + white * 0.0990460f;
-		b1 = 0.96300f * b1 + white * 0.2965164f;
-		b2 = 0.57000f * b2 + white * 1.0526913f;
-		float pink = b0 + b1 + b2 + white * 0.1848f;
-		out[i] = pink * (1.0f / 10.4f);
-	}
-	this->b0 = b0;
-	this->b1 = b1;
-	this->b2 = b2;
-}
-
-static void generate_pink2(struct module *m, float *out) {
-	struct noise *this = (struct noise *)m->priv;
-	float b0 = this->b0;
-	float b1 = this->b1;
-	float b2 = this->b2;
-	float b3 = this->b3;
-	float b4 = this->b4;
-	float b5 = this->b5;
-	float b6 = this->b6;
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		float white = randf(&this->rand);
-		b0 = 0.99886f * b0 + white * 0.0555179f;
-		b1 = 0.99332f * b1 + white * 0.0750759f;
-		b2 = 0.96900f * b2 + white * 0.1538520f;
-		b3 = 0.86650f * b3 + white * 0.3104856f;
-		b4 = 0.55000f * b4 + white * 0.5329522f;
-		b5 = -0.7616f * b5 - white * 0.0168980f;
-		float pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
-		b6 = white * 0.115926f;
-		out[i] = pink * (1.0f / 10.2f);
-	}
-	this->b0 = b0;
-	this->b1 = b1;
-	this->b2 = b2;
-	this->b3 = b3;
-	this->b4 = b4;
-	this->b5 = b5;
-	this->b6 = b6;
-}
-
 /******************************************************************************
  * module functions
  */
@@ -132,7 +58,7 @@ static int noise_alloc(struct module *m, va_list vargs) {
 	}
 
 	/* initialise the random seed */
-	rand_init(0, &this->rand);
+	noise_gen_init(&this->gen, 0);
 
 	return 0;
 
@@ -153,16 +79,16 @@ static bool noise_process(struct module *m, float *bufs[]) {
 
 	switch (this->type) {
 	case NOISE_TYPE_PINK1:
-		generate_pink1(m, out);
+		noise_gen_pink1(&this->gen, out, AudioBufferSize);
 		break;
 	case NOISE_TYPE_PINK2:
-		generate_pink2(m, out);
+		noise_gen_pink2(&this->gen, out, AudioBufferSize);
 		break;
 	case NOISE_TYPE_WHITE:
-		generate_white(m, out);
+		noise_gen_white(&this->gen, out, AudioBufferSize);
 		break;
 	case NOISE_TYPE_BROWN:
-		generate_brown(m, out);
+		noise_gen_brown(&this->gen, out, AudioBufferSize);
 		break;
 	default:
 		LOG_ERR("bad noise type %d", this->type);
@@ -35,6 +35,18 @@ enum {
 	NOISE_TYPE_MAX		/* must be last */
 };
 
+/******************************************************************************
+ * unison waves
+ */
+
+enum {
+	UNISON_WAVE_NULL,
+	UNISON_WAVE_SAW,	/* polyblep sawtooth */
+	UNISON_WAVE_GOOM,	/* goom wave */
+	UNISON_WAVE_WAVETABLE,	/* wavetable */
+	UNISON_WAVE_MAX		/* must be last */
+};
+
 /*****************************************************************************/
 
 #endif				/* GGM_SRC_MODULE_OSC_OSC_H */
@@ -2,6 +2,13 @@
  * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
  *
  * SPDX-License-Identifier: Apache-2.0
+ *
+ * Sine Wave Oscillator
+ * The optional "fm" (Hz) and "pm" (radians) audio inputs modulate the
+ * frequency and phase of the oscillator.
+ *
+ * With "fixed" set the wave is generated from a q15 cosine table with
+ * integer interpolation (for targets without float SIMD).
  */
 
 #include "ggm.h"
@@ -14,6 +21,7 @@ struct sine {
 	float freq;		/* base frequency */
 	uint32_t x;		/* current x-value */
 	uint32_t xstep;		/* current x-step */
+	bool fixed;		/* q15 processing */
 };
 
 /******************************************************************************
@@ -58,6 +66,14 @@ static void sine_port_note(struct module *m, const struct event *e) {
 	sine_set_frequency(m, freq);
 }
 
+/* sine_port_fixed selects q15 (true) or float (false) processing */
+static void sine_port_fixed(struct module *m, const struct event *e) {
+	struct sine *this = (struct sine *)m->priv;
+
+	this->fixed = event_get_bool(e);
+	LOG_DBG("%s fixed %d", m->name, this->fixed);
+}
+
 /******************************************************************************
  * module functions
  */
@@ -83,13 +99,18 @@ static void sine_free(struct module *m) {
 
 static bool sine_process(struct module *m, float *buf[]) {
 	struct sine *this = (struct sine *)m->priv;
-	float *out = buf[0];
-
-	for (int i = 0; i < AudioBufferSize; i++) {
-		out[i] = cos_lookup(this->x);
-		this->x += this->xstep;
-		// fm: this->x += (uint32_t)((this->freq + fm[i]) * FrequencyScale);
-		// pm: this->x += (uint32_t)((float)this->xstep + (pm[i] * PhaseScale));
+	float *fm = buf[0];
+	float *pm = buf[1];
+	float *out = buf[2];
+	uint32_t x[AudioBufferSize];
+
+	phase_gen_mod(x, &this->x, this->xstep, fm, pm, FrequencyScale, AudioBufferSize);
+	if (this->fixed) {
+		q15_t y[AudioBufferSize];
+		cos_lookup_block_q15(x, y);
+		block_q15_to_float(out, y);
+	} else {
+		cos_lookup_block(x, out);
 	}
 	return true;
 }
@@ -102,6 +123,9 @@ static const struct port_info in_ports[] = {
 	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = sine_port_reset},
 	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = sine_port_frequency},
 	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = sine_port_note},
+	{.name = "fixed",.type = PORT_TYPE_BOOL,.pf = sine_port_fixed},
+	{.name = "fm",.type = PORT_TYPE_AUDIO,},
+	{.name = "pm",.type = PORT_TYPE_AUDIO,},
 	PORT_EOL,
 };
 
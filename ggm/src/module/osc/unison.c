@@ -0,0 +1,369 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Unison Oscillator
+ *
+ * 4 to 16 detuned copies (voices) of a band-limited saw, goom or wavetable
+ * oscillator summed into a stereo output (e.g. a supersaw). The voices are
+ * spread evenly across the detune range and the stereo field, with the most
+ * detuned voices at the edges.
+ *
+ * Doing this in one module means one set of events, one envelope and one
+ * process call for the whole stack. Each voice is a block pass: phases from
+ * the shared phase generator, the wave kernel (4 samples at a time where
+ * the kernel is vectorized) and a multiply-accumulate into each output.
+ *
+ * Arguments:
+ * int, number of voices (4..16)
+ * int, wave (UNISON_WAVE_*)
+ * int, wavetable shape (WAVETABLE_SHAPE_*) for UNISON_WAVE_WAVETABLE
+ * const float *, WT_SIZE samples for WAVETABLE_SHAPE_USER (a single cycle)
+ */
+
+#include "ggm.h"
+#include "osc/osc.h"
+
+/******************************************************************************
+ * private state
+ */
+
+#define UNISON_MIN_VOICES 4
+#define UNISON_MAX_VOICES 16
+
+/* UNISON_DETUNE is the detune of the outermost voices at detune = 1 (cents) */
+#define UNISON_DETUNE (50.f)
+
+/* UNISON_PHASE spreads the start phases of the voices (golden ratio) */
+#define UNISON_PHASE (0x9e3779b9U)
+
+struct unison_voice {
+	float pos;		/* position in the stack -1..1 */
+	float ratio;		/* frequency ratio */
+	float gl;		/* left gain */
+	float gr;		/* right gain */
+	uint32_t x;		/* phase position */
+	uint32_t xstep;		/* phase step per sample */
+	struct goom_wave goom;	/* goom wave shape */
+};
+
+struct unison {
+	int voices;		/* number of voices */
+	int wave;		/* wave type */
+	struct wt_table *table;	/* shared wavetable (UNISON_WAVE_WAVETABLE) */
+	float freq;		/* base frequency */
+	float detune;		/* detune 0..1 */
+	float spread;		/* stereo spread 0..1 */
+	float duty;		/* goom duty cycle */
+	float slope;		/* goom slope */
+	float norm;		/* output normalisation 1/sqrt(voices) */
+	struct unison_voice voice[UNISON_MAX_VOICES];
+};
+
+/******************************************************************************
+ * unison functions
+ */
+
+/* unison_set_frequency sets the phase step of each voice */
+static void unison_set_frequency(struct unison *this) {
+	for (int i = 0; i < this->voices; i++) {
+		struct unison_voice *v = &this->voice[i];
+		float freq = clampf(this->freq * v->ratio, 0.f, 0.5f * (float)AudioSampleFrequency);
+		v->xstep = (uint32_t) (freq * FrequencyScale);
+		goom_wave_step(&v->goom, v->xstep);
+	}
+}
+
+/* unison_set_detune sets the frequency ratio of each voice */
+static void unison_set_detune(struct unison *this) {
+	float k = this->detune * (UNISON_DETUNE / 1200.f);
+
+	for (int i = 0; i < this->voices; i++) {
+		struct unison_voice *v = &this->voice[i];
+		v->ratio = pow2(v->pos * k);
+	}
+	unison_set_frequency(this);
+}
+
+/* unison_set_spread sets the left/right gains of each voice */
+static void unison_set_spread(struct unison *this) {
+	for (int i = 0; i < this->voices; i++) {
+		struct unison_voice *v = &this->voice[i];
+		/* constant power pan, 0 (left) .. Pi/2 (right) */
+		float pan = (1.f + (v->pos * this->spread)) * (0.25f * Pi);
+		v->gl = this->norm * cosf(pan);
+		v->gr = this->norm * sinf(pan);
+	}
+}
+
+/* unison_set_shape sets the goom wave shape of each voice */
+static void unison_set_shape(struct unison *this) {
+	for (int i = 0; i < this->voices; i++) {
+		goom_wave_shape(&this->voice[i].goom, this->duty, this->slope);
+	}
+}
+
+/* unison_reset resets the voice phases */
+static void unison_reset(struct unison *this) {
+	for (int i = 0; i < this->voices; i++) {
+		this->voice[i].x = (uint32_t) i * UNISON_PHASE;
+	}
+}
+
+/* unison_saw generates a polyblep sawtooth for a block of phases */
+static void unison_saw(const uint32_t *x, uint32_t xstep, float *out) {
+	float dt = blep_phase(xstep);
+
+	if (xstep == 0) {
+		for (int i = 0; i < AudioBufferSize; i++) {
+			out[i] = (2.f * blep_phase(x[i])) - 1.f;
+		}
+		return;
+	}
+	for (int i = 0; i < AudioBufferSize; i++) {
+		float t = blep_phase(x[i]);
+		/* step of -2 at the wrap */
+		out[i] = (2.f * t) - 1.f - polyblep(t, dt);
+	}
+}
+
+/* unison_norm returns 1/sqrt(n) (newton's method) */
+static float unison_norm(int n) {
+	float s = (float)n;
+
+	for (int i = 0; i < 8; i++) {
+		s = 0.5f * (s + ((float)n / s));
+	}
+	return 1.f / s;
+}
+
+/******************************************************************************
+ * MIDI to port event conversion functions
+ */
+
+/* unison_midi_cc converts a cc message to a 0..1 float event */
+static void unison_midi_cc(struct event *dst, const struct event *src) {
+	event_set_float(dst, event_get_midi_cc_float(src));
+}
+
+/******************************************************************************
+ * module port functions
+ */
+
+/* unison_port_reset resets the phases of the voices */
+static void unison_port_reset(struct module *m, const struct event *e) {
+	bool reset = event_get_bool(e);
+
+	if (reset) {
+		struct unison *this = (struct unison *)m->priv;
+		LOG_DBG("%s:reset phase", m->name);
+		unison_reset(this);
+	}
+}
+
+/* unison_port_frequency sets the base frequency (Hz) */
+static void unison_port_frequency(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->freq = clampf_lo(event_get_float(e), 0.f);
+	LOG_DBG("%s:frequency %f Hz", m->name, this->freq);
+	unison_set_frequency(this);
+}
+
+/* unison_port_note is the pitch bent MIDI note (float) used to set frequency */
+static void unison_port_note(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->freq = midi_to_frequency(event_get_float(e));
+	LOG_DBG("%s:note %f", m->name, event_get_float(e));
+	unison_set_frequency(this);
+}
+
+/* unison_port_detune sets the detune of the voices 0..1 */
+static void unison_port_detune(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->detune = clampf(event_get_float(e), 0.f, 1.f);
+	LOG_INF("%s:detune %f", m->name, this->detune);
+	unison_set_detune(this);
+}
+
+/* unison_port_spread sets the stereo spread of the voices 0..1 */
+static void unison_port_spread(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->spread = clampf(event_get_float(e), 0.f, 1.f);
+	LOG_INF("%s:spread %f", m->name, this->spread);
+	unison_set_spread(this);
+}
+
+/* unison_port_duty sets the goom wave duty cycle */
+static void unison_port_duty(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->duty = clampf(event_get_float(e), 0.f, 1.f);
+	LOG_INF("%s:duty %f", m->name, this->duty);
+	unison_set_shape(this);
+}
+
+/* unison_port_slope sets the goom wave slope */
+static void unison_port_slope(struct module *m, const struct event *e) {
+	struct unison *this = (struct unison *)m->priv;
+
+	this->slope = clampf(event_get_float(e), 0.f, 1.f);
+	LOG_INF("%s:slope %f", m->name, this->slope);
+	unison_set_shape(this);
+}
+
+/******************************************************************************
+ * module functions
+ */
+
+static int unison_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct unison *this = ggm_calloc(1, sizeof(struct unison));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	/* number of voices */
+	int voices = va_arg(vargs, int);
+	if ((voices < UNISON_MIN_VOICES) || (voices > UNISON_MAX_VOICES)) {
+		LOG_ERR("bad number of voices %d", voices);
+		goto error;
+	}
+	this->voices = voices;
+
+	/* wave type */
+	int wave = va_arg(vargs, int);
+	if ((wave <= 0) || (wave >= UNISON_WAVE_MAX)) {
+		LOG_ERR("bad wave %d", wave);
+		goto error;
+	}
+	this->wave = wave;
+
+	/* wavetable shape */
+	if (wave == UNISON_WAVE_WAVETABLE) {
+		int shape = va_arg(vargs, int);
+		const float *src = NULL;
+		if ((shape <= 0) || (shape >= WAVETABLE_SHAPE_MAX)) {
+			LOG_ERR("bad wavetable shape %d", shape);
+			goto error;
+		}
+		if (shape == WAVETABLE_SHAPE_USER) {
+			src = va_arg(vargs, const float *);
+			if (src == NULL) {
+				LOG_ERR("no user wavetable");
+				goto error;
+			}
+		}
+		this->table = wt_get(shape, src);
+		if (this->table == NULL) {
+			goto error;
+		}
+	}
+
+	/* spread the voices evenly across -1..1 */
+	for (int i = 0; i < voices; i++) {
+		this->voice[i].pos = ((2.f * (float)i) / (float)(voices - 1)) - 1.f;
+	}
+	this->norm = unison_norm(voices);
+
+	/* defaults */
+	this->duty = 0.5f;
+	this->slope = 0.5f;
+	this->detune = 0.25f;
+	this->spread = 0.5f;
+	unison_set_shape(this);
+	unison_set_detune(this);
+	unison_set_spread(this);
+	unison_reset(this);
+
+	return 0;
+
+ error:
+	ggm_free(this);
+	return -1;
+}
+
+static void unison_free(struct module *m) {
+	struct unison *this = (struct unison *)m->priv;
+
+	if (this->table != NULL) {
+		wt_put(this->table);
+	}
+	ggm_free(this);
+}
+
+static bool unison_process(struct module *m, float *bufs[]) {
+	struct unison *this = (struct unison *)m->priv;
+	float *fm = bufs[0];
+	float *pm = bufs[1];
+	float *out0 = bufs[2];
+	float *out1 = bufs[3];
+	uint32_t x[AudioBufferSize];
+	float buf[AudioBufferSize];
+
+	block_zero(out0);
+	block_zero(out1);
+
+	for (int i = 0; i < this->voices; i++) {
+		struct unison_voice *v = &this->voice[i];
+		/* fm (Hz) is scaled with the voice frequency */
+		phase_gen_mod(x, &v->x, v->xstep, fm, pm, FrequencyScale * v->ratio, AudioBufferSize);
+		switch (this->wave) {
+		case UNISON_WAVE_SAW:
+			unison_saw(x, v->xstep, buf);
+			break;
+		case UNISON_WAVE_GOOM:
+			goom_wave_gen(&v->goom, x, buf);
+			break;
+		case UNISON_WAVE_WAVETABLE:
+			wt_gen(this->table, x, v->xstep, buf);
+			break;
+		}
+		block_mac_k(out0, buf, v->gl);
+		block_mac_k(out1, buf, v->gr);
+	}
+	return true;
+}
+
+/******************************************************************************
+ * module information
+ */
+
+static const struct port_info in_ports[] = {
+	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = unison_port_reset},
+	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = unison_port_frequency},
+	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = unison_port_note},
+	{.name = "detune",.type = PORT_TYPE_FLOAT,.pf = unison_port_detune,.mf = unison_midi_cc},
+	{.name = "spread",.type = PORT_TYPE_FLOAT,.pf = unison_port_spread,.mf = unison_midi_cc},
+	{.name = "duty",.type = PORT_TYPE_FLOAT,.pf = unison_port_duty,.mf = unison_midi_cc},
+	{.name = "slope",.type = PORT_TYPE_FLOAT,.pf = unison_port_slope,.mf = unison_midi_cc},
+	{.name = "fm",.type = PORT_TYPE_AUDIO,},
+	{.name = "pm",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+static const struct port_info out_ports[] = {
+	{.name = "out0",.type = PORT_TYPE_AUDIO,},
+	{.name = "out1",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+const struct module_info osc_unison_module = {
+	.mname = "osc/unison",
+	.iname = "unison",
+	.in = in_ports,
+	.out = out_ports,
+	.alloc = unison_alloc,
+	.free = unison_free,
+	.process = unison_process,
+};
+
+MODULE_REGISTER(osc_unison_module);
+
+/*****************************************************************************/
@@ -0,0 +1,160 @@
+/******************************************************************************
+ * Copyright (c) 2019 Jason T. Harris. (sirmanlypowers@gmail.com)
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Wavetable Oscillator
+ *
+ * Plays a single cycle waveform from a set of shared band-limited mip levels
+ * (see core/wavetable.c).
+ *
+ * Arguments:
+ * int, wavetable shape (WAVETABLE_SHAPE_*)
+ * const float *, WT_SIZE samples for WAVETABLE_SHAPE_USER (a single cycle)
+ */
+
+#include "ggm.h"
+
+/******************************************************************************
+ * private state
+ */
+
+struct wavetable {
+	struct wt_table *table;	/* shared mip level tables */
+	float freq;		/* base frequency */
+	uint32_t x;		/* current x-value */
+	uint32_t xstep;		/* current x-step */
+};
+
+/******************************************************************************
+ * wavetable functions
+ */
+
+static void wavetable_set_frequency(struct module *m, float freq) {
+	struct wavetable *this = (struct wavetable *)m->priv;
+
+	LOG_DBG("%s set frequency %f Hz", m->name, freq);
+	this->freq = freq;
+	this->xstep = (uint32_t) (freq * FrequencyScale);
+}
+
+/******************************************************************************
+ * module port functions
+ */
+
+/* wavetable_port_reset resets the phase of the oscillator */
+static void wavetable_port_reset(struct module *m, const struct event *e) {
+	bool reset = event_get_bool(e);
+
+	if (reset) {
+		struct wavetable *this = (struct wavetable *)m->priv;
+		LOG_DBG("%s phase reset", m->name);
+		this->x = 0;
+	}
+}
+
+/* wavetable_port_frequency sets the frequency of the oscillator */
+static void wavetable_port_frequency(struct module *m, const struct event *e) {
+	float freq = clampf_lo(event_get_float(e), 0);
+
+	wavetable_set_frequency(m, freq);
+}
+
+/* wavetable_port_note is the pitch bent MIDI note (float) used to set frequency */
+static void wavetable_port_note(struct module *m, const struct event *e) {
+	float freq = midi_to_frequency(event_get_float(e));
+
+	wavetable_set_frequency(m, freq);
+}
+
+/******************************************************************************
+ * module functions
+ */
+
+static int wavetable_alloc(struct module *m, va_list vargs) {
+	/* allocate the private data */
+	struct wavetable *this = ggm_calloc(1, sizeof(struct wavetable));
+
+	if (this == NULL) {
+		return -1;
+	}
+	m->priv = (void *)this;
+
+	/* get the wave shape */
+	int shape = va_arg(vargs, int);
+	const float *src = NULL;
+	if ((shape <= 0) || (shape >= WAVETABLE_SHAPE_MAX)) {
+		LOG_ERR("bad wavetable shape %d", shape);
+		goto error;
+	}
+	if (shape == WAVETABLE_SHAPE_USER) {
+		src = va_arg(vargs, const float *);
+		if (src == NULL) {
+			LOG_ERR("no user wavetable");
+			goto error;
+		}
+	}
+
+	/* get the shared tables */
+	this->table = wt_get(shape, src);
+	if (this->table == NULL) {
+		goto error;
+	}
+
+	return 0;
+
+ error:
+	ggm_free(this);
+	return -1;
+}
+
+static void wavetable_free(struct module *m) {
+	struct wavetable *this = (struct wavetable *)m->priv;
+
+	wt_put(this->table);
+	ggm_free(this);
+}
+
+static bool wavetable_process(struct module *m, float *bufs[]) {
+	struct wavetable *this = (struct wavetable *)m->priv;
+	float *fm = bufs[0];
+	float *pm = bufs[1];
+	float *out = bufs[2];
+	uint32_t x[AudioBufferSize];
+
+	phase_gen_mod(x, &this->x, this->xstep, fm, pm, FrequencyScale, AudioBufferSize);
+	wt_gen(this->table, x, this->xstep, out);
+	return true;
+}
+
+/******************************************************************************
+ * module information
+ */
+
+static const struct port_info in_ports[] = {
+	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = wavetable_port_reset},
+	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = wavetable_port_frequency},
+	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = wavetable_port_note},
+	{.name = "fm",.type = PORT_TYPE_AUDIO,},
+	{.name = "pm",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+static const struct port_info out_ports[] = {
+	{.name = "out",.type = PORT_TYPE_AUDIO,},
+	PORT_EOL,
+};
+
+const struct module_info osc_wavetable_module = {
+	.mname = "osc/wavetable",
+	.iname = "wavetable",
+	.in = in_ports,
+	.out = out_ports,
+	.alloc = wavetable_alloc,
+	.free = wavetable_free,
+	.process = wavetable_process,
+};
+
+MODULE_REGISTER(osc_wavetable_module);
+
+/*****************************************************************************/
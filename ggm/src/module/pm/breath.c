@@ -7,14 +7,13 @@
  */
 
 #include "ggm.h"
-#include "osc/osc.h"
 
 /******************************************************************************
  * private state
  */
 
 struct breath {
-	struct module *noise;	/* noise module */
+	int noise;		/* shared noise bus stream */
 	struct module *adsr;	/* adsr module */
 	float kn;		/* noise scale */
 	float ka;		/* amplitude scale */
@@ -102,7 +101,6 @@ static void breath_port_ka(struct module *m, const struct event *e) {
  */
 
 static int breath_alloc(struct module *m, va_list vargs) {
-	struct module *noise = NULL;
 	struct module *adsr = NULL;
 
 	/* allocate the private data */
@@ -116,12 +114,11 @@ static int breath_alloc(struct module *m, va_list vargs) {
 	/* set some defaults */
 	breath_set_scale(m, 0.5f, 1.f);
 
-	/* noise */
-	noise = module_new(m, "osc/noise", -1, NOISE_TYPE_WHITE);
-	if (noise == NULL) {
+	/* noise from the shared bus */
+	this->noise = synth_noise_subscribe(m->top);
+	if (this->noise < 0) {
 		goto error;
 	}
-	this->noise = noise;
 
 	/* adsr */
 	adsr = module_new(m, "env/adsr", -1);
@@ -137,8 +134,8 @@ static int breath_alloc(struct module *m, va_list vargs) {
 	return 0;
 
  error:
-	module_del(noise);
 	module_del(adsr);
+	synth_noise_unsubscribe(m->top, this->noise);
 	ggm_free(m->priv);
 	return -1;
 }
@@ -146,8 +143,8 @@ static int breath_alloc(struct module *m, va_list vargs) {
 static void breath_free(struct module *m) {
 	struct breath *this = (struct breath *)m->priv;
 
-	module_del(this->noise);
 	module_del(this->adsr);
+	synth_noise_unsubscribe(m->top, this->noise);
 	ggm_free(this);
 }
 
@@ -158,14 +155,12 @@ static bool breath_process(struct module *m, float *bufs[]) {
 	bool active = adsr->info->process(adsr, (float *[]) { env, });
 
 	if (active) {
-		struct module *noise = this->noise;
 		float *out = bufs[0];
+		float kn = this->kn * this->kd;
+		float kd = this->kd;
 		/* out = ((noise * env * kn) + env) * kd */
-		noise->info->process(noise, (float *[]) { out, });
-		block_mul(out, env);
-		block_mul_k(out, this->kn);
-		block_add(out, env);
-		block_mul_k(out, this->kd);
+		synth_noise(m->top, this->noise, out);
+		BLOCK_EXPR(out, i, ((out[i] * kn) + kd) * env[i]);
 	}
 
 	return active;
@@ -5,6 +5,7 @@
  */
 
 #include "ggm.h"
+#include "filter/filter.h"
 
 /******************************************************************************
  * private state
@@ -16,8 +17,23 @@ struct goom {
 	struct module *osc;	/* goom oscillator */
 	struct module *lpf;	/* low pass filter */
 	float vel;		/* note velocity */
+	float cutoff;		/* filter cutoff at the envelope peak (Hz) */
+	float depth;		/* envelope depth (0..1) */
 };
 
+/******************************************************************************
+ * goom functions
+ */
+
+/* goom_set_cutoff sets a constant filter cutoff when there is no envelope depth */
+static void goom_set_cutoff(struct module *m) {
+	struct goom *this = (struct goom *)m->priv;
+
+	if (this->depth == 0.f) {
+		event_in_float(this->lpf, "cutoff", this->cutoff, NULL);
+	}
+}
+
 /******************************************************************************
  * module port functions
  */
@@ -28,6 +44,7 @@ static void goom_port_reset(struct module *m, const struct event *e) {
 
 	/* forward the reset to the sub-modules */
 	event_in(this->amp_env, "reset", e, NULL);
+	event_in(this->lpf_env, "reset", e, NULL);
 	event_in(this->osc, "reset", e, NULL);
 }
 
@@ -50,6 +67,37 @@ static void goom_port_note(struct module *m, const struct event *e) {
 	event_in(this->osc, "note", e, NULL);
 }
 
+/* goom_port_frequency sets the voice frequency (Hz) */
+static void goom_port_frequency(struct module *m, const struct event *e) {
+	struct goom *this = (struct goom *)m->priv;
+
+	/* set the oscillator frequency */
+	event_in(this->osc, "frequency", e, NULL);
+}
+
+/* goom_port_cutoff sets the filter cutoff frequency at the envelope peak */
+static void goom_port_cutoff(struct module *m, const struct event *e) {
+	struct goom *this = (struct goom *)m->priv;
+
+	this->cutoff = clampf(event_get_float(e), 0.f, 0.5f * AudioSampleFrequency);
+	goom_set_cutoff(m);
+}
+
+/* goom_port_resonance sets the filter resonance (0..1) */
+static void goom_port_resonance(struct module *m, const struct event *e) {
+	struct goom *this = (struct goom *)m->priv;
+
+	event_in(this->lpf, "resonance", e, NULL);
+}
+
+/* goom_port_depth sets the depth of the filter envelope */
+static void goom_port_depth(struct module *m, const struct event *e) {
+	struct goom *this = (struct goom *)m->priv;
+
+	this->depth = clampf(event_get_float(e), 0.f, 1.f);
+	goom_set_cutoff(m);
+}
+
 /******************************************************************************
  * module functions
  */
@@ -80,6 +128,8 @@ static int goom_alloc(struct module *m, va_list vargs) {
 	if (lpf_env == NULL) {
 		goto error;
 	}
+	/* the filter envelope doesn't need audio rate accuracy */
+	event_in_bool(lpf_env, "control", true, NULL);
 	this->lpf_env = lpf_env;
 
 	/* goom oscillator */
@@ -90,12 +140,17 @@ static int goom_alloc(struct module *m, va_list vargs) {
 	this->osc = osc;
 
 	/* low pass filter */
-	lpf = module_new(m, "filter/svf", -1);;
+	lpf = module_new(m, "filter/svf", -1, SVF_TYPE_TRAPEZOIDAL);
 	if (lpf == NULL) {
 		goto error;
 	}
 	this->lpf = lpf;
 
+	/* filter envelope defaults (open filter) */
+	this->cutoff = 0.45f * AudioSampleFrequency;
+	this->depth = 0.f;
+	goom_set_cutoff(m);
+
 	return 0;
 
  error:
@@ -124,18 +179,31 @@ static bool goom_process(struct module *m, float *bufs[]) {
 	bool active = amp_env->info->process(amp_env, (float *[]) { env, });
 
 	if (active) {
-		// struct module *lpf_env = this->lpf_env;
+		struct module *lpf_env = this->lpf_env;
 		struct module *osc = this->osc;
 		struct module *lpf = this->lpf;
 		float *out = bufs[0];
 
 		float buf[AudioBufferSize];
+		float fc_buf[AudioBufferSize];
+		float *fc = NULL;
 
 		// get the oscillator output
-		osc->info->process(osc, (float *[]) { buf, });
+		osc->info->process(osc, (float *[]) { NULL, NULL, buf, });
+
+		// filter cutoff = cutoff * ((1 - depth) + (depth * env))
+		// The envelope always runs so it's in the right state if the depth changes.
+		if (!lpf_env->info->process(lpf_env, (float *[]) { fc_buf, })) {
+			block_zero(fc_buf);
+		}
+		if (this->depth != 0.f) {
+			// otherwise the cutoff is constant and has been set on the filter
+			fc = fc_buf;
+			block_mul_add_k(fc, this->cutoff * this->depth, this->cutoff * (1.f - this->depth));
+		}
 
 		// feed it to the LPF
-		lpf->info->process(lpf, (float *[]) { buf, out, });
+		lpf->info->process(lpf, (float *[]) { buf, fc, out, NULL, NULL, NULL, NULL, NULL, });
 
 		// apply the amplitude envelope
 		block_mul(out, env);
@@ -153,6 +221,10 @@ static const struct port_info in_ports[] = {
 	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = goom_port_reset},
 	{.name = "gate",.type = PORT_TYPE_FLOAT,.pf = goom_port_gate},
 	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = goom_port_note},
+	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = goom_port_frequency},
+	{.name = "cutoff",.type = PORT_TYPE_FLOAT,.pf = goom_port_cutoff},
+	{.name = "depth",.type = PORT_TYPE_FLOAT,.pf = goom_port_depth},
+	{.name = "resonance",.type = PORT_TYPE_FLOAT,.pf = goom_port_resonance},
 	PORT_EOL,
 };
 
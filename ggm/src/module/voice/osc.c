@@ -5,6 +5,7 @@
  *
  * Oscillator Voice
  * This voice is a generic oscillator with an ADSR envelope applied to it.
+ * "fixed" is forwarded to the oscillator and envelope (e.g. osc/sine).
  *
  * Arguments:
  * module_func func, function to create an oscillator module
@@ -21,6 +22,7 @@ struct osc {
 	struct module *osc;	/* oscillator */
 	port_func gate;		/* port function cache */
 	port_func freq;		/* port function cache */
+	int out;		/* oscillator output buffer index */
 };
 
 /******************************************************************************
@@ -51,6 +53,21 @@ static void osc_port_note(struct module *m, const struct event *e) {
 	event_in_float(this->osc, "frequency", f, &this->freq);
 }
 
+/* osc_port_frequency sets the voice frequency (Hz) */
+static void osc_port_frequency(struct module *m, const struct event *e) {
+	struct osc *this = (struct osc *)m->priv;
+
+	event_in(this->osc, "frequency", e, &this->freq);
+}
+
+/* osc_port_fixed selects fixed point processing in the sub-modules */
+static void osc_port_fixed(struct module *m, const struct event *e) {
+	struct osc *this = (struct osc *)m->priv;
+
+	event_in(this->adsr, "fixed", e, NULL);
+	event_in(this->osc, "fixed", e, NULL);
+}
+
 /******************************************************************************
  * module functions
  */
@@ -74,6 +91,8 @@ static int osc_alloc(struct module *m, va_list vargs) {
 		goto error;
 	}
 	this->osc = osc;
+	/* the output follows any (unconnected) audio inputs, e.g. fm/pm */
+	this->out = port_count_by_type(osc->info->in, PORT_TYPE_AUDIO);
 
 	/* adsr */
 	adsr = module_new(m, "env/adsr", -1);
@@ -108,7 +127,9 @@ static bool osc_process(struct module *m, float *buf[]) {
 	if (active) {
 		struct module *osc = this->osc;
 		float *out = buf[0];
-		osc->info->process(osc, (float *[]) { out, });
+		float *obufs[MAX_AUDIO_PORTS] = { NULL };
+		obufs[this->out] = out;
+		osc->info->process(osc, obufs);
 		block_mul(out, env);
 	}
 
@@ -123,6 +144,8 @@ static const struct port_info in_ports[] = {
 	{.name = "reset",.type = PORT_TYPE_BOOL,.pf = osc_port_reset},
 	{.name = "gate",.type = PORT_TYPE_FLOAT,.pf = osc_port_gate},
 	{.name = "note",.type = PORT_TYPE_FLOAT,.pf = osc_port_note},
+	{.name = "frequency",.type = PORT_TYPE_FLOAT,.pf = osc_port_frequency},
+	{.name = "fixed",.type = PORT_TYPE_BOOL,.pf = osc_port_fixed},
 	PORT_EOL,
 };
 
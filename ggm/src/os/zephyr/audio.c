@@ -44,7 +44,7 @@ int audio_init(struct audio_drv *audio) {
 	i2s_cfg.block_size = AudioBufferBytes;
 	i2s_cfg.timeout = 0;
 
-	err = k_mem_slab_init(&audio->buffer_mem_slab, audio->buffer, AudioBufferBytes, AudioOutputChannels * 2);
+	err = k_mem_slab_init(&audio->buffer_mem_slab, audio->buffer, AudioBufferBytes, AudioBufferBlocks);
 	if (err != 0) {
 		LOG_ERR("k_mem_slab_init failed %d", err);
 		return -1;
@@ -77,6 +77,32 @@ int audio_init(struct audio_drv *audio) {
 //-----------------------------------------------------------------------------
 
 int audio_start(struct audio_drv *audio) {
+	rand_init(0, &audio->dither);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+// audio_write converts the left/right buffers to 16-bit interleaved PCM and queues them for the i2s
+int audio_write(struct audio_drv *audio, const float *l, const float *r) {
+	void *block;
+	int err;
+
+	err = k_mem_slab_alloc(&audio->buffer_mem_slab, &block, K_FOREVER);
+	if (err != 0) {
+		LOG_ERR("k_mem_slab_alloc failed %d", err);
+		return -1;
+	}
+
+	block_to_pcm16((int16_t *) block, l, r, &audio->dither);
+
+	err = i2s_write(audio->i2s, block, AudioBufferBytes);
+	if (err != 0) {
+		LOG_ERR("i2s_write failed %d", err);
+		k_mem_slab_free(&audio->buffer_mem_slab, &block);
+		return -1;
+	}
+
 	return 0;
 }
 
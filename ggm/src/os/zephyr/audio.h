@@ -13,19 +13,22 @@
 //-----------------------------------------------------------------------------
 
 #define AudioOutputChannels 2
-#define AudioBufferBytes (AudioBufferSize * sizeof(int16_t))
+#define AudioBufferBytes (AudioBufferSize * AudioOutputChannels * sizeof(int16_t))
+#define AudioBufferBlocks 2
 
 struct audio_drv {
 	const struct device *dac;
 	const struct device *i2s;
 	struct k_mem_slab buffer_mem_slab;
-	int16_t buffer[AudioBufferSize * AudioOutputChannels * 2];
+	uint32_t dither;	/* random state for TPDF dither */
+	int16_t buffer[AudioBufferSize * AudioOutputChannels * AudioBufferBlocks] __aligned(4);
 };
 
 //-----------------------------------------------------------------------------
 
 int audio_init(struct audio_drv *audio);
 int audio_start(struct audio_drv *audio);
+int audio_write(struct audio_drv *audio, const float *l, const float *r);
 
 //-----------------------------------------------------------------------------
 
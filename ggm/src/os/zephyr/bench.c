@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------------------
+/*
+
+Copyright (c) 2021 Jason T. Harris. (sirmanlypowers@gmail.com)
+SPDX-License-Identifier: Apache-2.0
+
+On target benchmarks. Enable with -DGGM_BENCH=ON.
+
+The block operations are timed against plain C reference loops so the
+effect of the CMSIS-DSP mappings (-DGGM_CMSIS_DSP) can be measured.
+
+The cosine lookup is timed per-sample and per-block, and the spurious free
+dynamic range for the configured table size (-DGGM_COS_LUT_BITS) is measured
+with a DFT of a coherently sampled tone.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <zephyr.h>
+
+#include "ggm.h"
+#include "bench.h"
+
+//-----------------------------------------------------------------------------
+
+#define BENCH_ITERATIONS 1000
+
+static float buf0[AudioBufferSize];
+static float buf1[AudioBufferSize];
+static uint32_t phase[AudioBufferSize];
+static q15_t qbuf0[AudioBufferSize] __aligned(4);
+static q15_t qbuf1[AudioBufferSize] __aligned(4);
+
+struct bench {
+	const char *name;
+	void (*func)(void);
+};
+
+//-----------------------------------------------------------------------------
+// plain C reference loops
+
+static void ref_mul(void) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] *= buf1[i];
+	}
+}
+
+static void ref_add(void) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] += buf1[i];
+	}
+}
+
+static void ref_mul_k(void) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] *= 0.999f;
+	}
+}
+
+static void ref_copy(void) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] = buf1[i];
+	}
+}
+
+//-----------------------------------------------------------------------------
+// block operations
+
+static void blk_mul(void) {
+	block_mul(buf0, buf1);
+}
+
+static void blk_add(void) {
+	block_add(buf0, buf1);
+}
+
+static void blk_mul_k(void) {
+	block_mul_k(buf0, 0.999f);
+}
+
+static void blk_copy(void) {
+	block_copy(buf0, buf1);
+}
+
+static void cos_sample(void) {
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] = cos_lookup(phase[i]);
+	}
+}
+
+static void cos_block(void) {
+	cos_lookup_block(phase, buf0);
+}
+
+//-----------------------------------------------------------------------------
+// fixed point operations
+
+static void blk_mul_q15(void) {
+	block_mul_q15(qbuf0, qbuf1);
+}
+
+static void blk_add_q15(void) {
+	block_add_q15(qbuf0, qbuf1);
+}
+
+static void cos_block_q15(void) {
+	cos_lookup_block_q15(phase, qbuf0);
+}
+
+//-----------------------------------------------------------------------------
+
+static const struct bench bench_list[] = {
+	{"ref_mul", ref_mul},
+	{"block_mul", blk_mul},
+	{"ref_add", ref_add},
+	{"block_add", blk_add},
+	{"ref_mul_k", ref_mul_k},
+	{"block_mul_k", blk_mul_k},
+	{"ref_copy", ref_copy},
+	{"block_copy", blk_copy},
+	{"cos_lookup", cos_sample},
+	{"cos_lookup_block", cos_block},
+	{"block_mul_q15", blk_mul_q15},
+	{"block_add_q15", blk_add_q15},
+	{"cos_lookup_block_q15", cos_block_q15},
+	{NULL, NULL},
+};
+
+// bench_cycles returns the average number of cycles for a benchmark function
+static uint32_t bench_cycles(void (*func)(void)) {
+	uint32_t start = k_cycle_get_32();
+
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		func();
+	}
+	return (k_cycle_get_32() - start) / BENCH_ITERATIONS;
+}
+
+//-----------------------------------------------------------------------------
+// cosine lookup spurious free dynamic range
+
+#define SFDR_N 1021		// DFT size (prime, so the phases fall between table points)
+#define SFDR_BIN 31		// test tone bin
+
+static float sfdr_buf[SFDR_N];
+
+// bench_db returns 10 * log10(x), or -999 for x <= 0
+static double bench_db(double x) {
+	int e = 0;
+
+	if (x <= 0.0) {
+		return -999.0;
+	}
+
+	while (x >= 2.0) {
+		x *= 0.5;
+		e++;
+	}
+	while (x < 1.0) {
+		x *= 2.0;
+		e--;
+	}
+	// ln(x) = 2 * atanh((x - 1)/(x + 1))
+	double z = (x - 1.0) / (x + 1.0);
+	double z2 = z * z;
+	double ln = 2.0 * z * (1.0 + z2 * (1.0 / 3.0 + z2 * (1.0 / 5.0 + z2 * (1.0 / 7.0 + z2 * (1.0 / 9.0)))));
+	return 10.0 * ((ln * 1.4426950408889634) + (double)e) * 0.30102999566398120;
+}
+
+// bench_sfdr returns the SFDR (dB) of cos_lookup()
+static double bench_sfdr(void) {
+	double c, s;
+	double wc = 1.0;
+	double ws = 0.0;
+	double signal = 0.0;
+	double spur = 0.0;
+
+	// cos/sin of the DFT bin step
+	cos_sin_small(2.0 * 3.14159265358979323846 / (double)SFDR_N, &c, &s);
+
+	// coherently sampled test tone
+	for (size_t i = 0; i < SFDR_N; i++) {
+		uint64_t ph = (((uint64_t) i * SFDR_BIN) << 32) / SFDR_N;
+		sfdr_buf[i] = cos_lookup((uint32_t) ph);
+	}
+
+	// goertzel power for each bin up to nyquist
+	for (size_t k = 0; k <= SFDR_N / 2; k++) {
+		double coeff = 2.0 * wc;
+		double s1 = 0.0;
+		double s2 = 0.0;
+		for (size_t i = 0; i < SFDR_N; i++) {
+			double s0 = (double)sfdr_buf[i] + (coeff * s1) - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+		double power = (s1 * s1) + (s2 * s2) - (coeff * s1 * s2);
+		if (k == SFDR_BIN) {
+			signal = power;
+		} else if (power > spur) {
+			spur = power;
+		}
+		// next bin
+		double wc_next = (wc * c) - (ws * s);
+		ws = (wc * s) + (ws * c);
+		wc = wc_next;
+	}
+
+	if (spur == 0.0) {
+		spur = 1e-30;
+	}
+	return bench_db(signal / spur);
+}
+
+//-----------------------------------------------------------------------------
+
+void bench_run(void) {
+	// the benchmarks run before synth_new(), so build the tables here
+	lut_init();
+
+	for (size_t i = 0; i < AudioBufferSize; i++) {
+		buf0[i] = 0.5f;
+		buf1[i] = 1.f;
+		qbuf0[i] = Q15_MAX / 2;
+		qbuf1[i] = Q15_MAX;
+		phase[i] = (uint32_t) i * 0x01234567;
+	}
+
+#if defined(GGM_CMSIS_DSP)
+	LOG_INF("block operations use CMSIS-DSP");
+#endif
+
+	const struct bench *b = bench_list;
+	while (b->name != NULL) {
+		LOG_INF("%s %u cycles/block", b->name, bench_cycles(b->func));
+		b++;
+	}
+
+	int sfdr = (int)(bench_sfdr() * 10.0);
+	LOG_INF("cos_lookup sfdr %d.%d dB", sfdr / 10, sfdr % 10);
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,21 @@
+//-----------------------------------------------------------------------------
+/*
+
+ Copyright (c) 2021 Jason T. Harris. (sirmanlypowers@gmail.com)
+ SPDX-License-Identifier: Apache-2.0
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef BENCH_H
+#define BENCH_H
+
+//-----------------------------------------------------------------------------
+
+void bench_run(void);
+
+//-----------------------------------------------------------------------------
+
+#endif				// BENCH_H
+
+//-----------------------------------------------------------------------------
@@ -12,6 +12,7 @@
 #include "ggm.h"
 #include "module.h"
 #include "audio.h"
+#include "bench.h"
 
 //-----------------------------------------------------------------------------
 
@@ -35,6 +36,10 @@ int main(void) {
 
 	LOG_INF("GooGooMuck %s (%s)", GGM_VERSION, CONFIG_BOARD);
 
+#if defined(GGM_BENCH)
+	bench_run();
+#endif
+
 	rc = audio_init(&ggm_audio);
 	if (rc != 0) {
 		LOG_DBG("audio_init failed %d", rc);